@@ -0,0 +1,313 @@
+#include "AnimationClip.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ANIMATION_CLIP_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+    const size_t LANES = 4;
+    const float PACKED_ONE = 32767.0f;
+
+    std::int16_t packComponent(const float value)
+    {
+        return static_cast<std::int16_t>(std::lround(std::max(-1.0f, std::min(1.0f, value)) * PACKED_ONE));
+    }
+
+#ifdef ANIMATION_CLIP_SSE2
+    __m128 loadLanes(const float* values)
+    {
+        return _mm_loadu_ps(values);
+    }
+
+    __m128 loadLanes(const std::int16_t* values)
+    {
+        // Sign extend by placing each value in the high half of a 32 bit lane. The scale is left out, nlerp
+        // normalizes anyway.
+        const auto packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(values));
+        return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+    }
+
+    void lerpLanes(const float* from, const float* to, const float factor, float* out, const size_t count)
+    {
+        const auto t = _mm_set1_ps(factor);
+        for (size_t i = 0; i < count; i += LANES) {
+            const auto a = _mm_loadu_ps(from + i);
+            const auto b = _mm_loadu_ps(to + i);
+            _mm_storeu_ps(out + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t)));
+        }
+    }
+
+    // Four channels per iteration, one quaternion component per register
+    template <typename T>
+    void nlerpLanes(const T* const from[4], const T* const to[4], const float factor, float* const out[4], const size_t count)
+    {
+        const auto t = _mm_set1_ps(factor);
+        for (size_t i = 0; i < count; i += LANES) {
+            __m128 q[4];
+            auto lengthSquared = _mm_setzero_ps();
+            for (auto c = 0; c < 4; ++c) {
+                const auto a = loadLanes(from[c] + i);
+                const auto b = loadLanes(to[c] + i);
+                q[c] = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+                lengthSquared = _mm_add_ps(lengthSquared, _mm_mul_ps(q[c], q[c]));
+            }
+            const auto inverseLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+            for (auto c = 0; c < 4; ++c) {
+                _mm_storeu_ps(out[c] + i, _mm_mul_ps(q[c], inverseLength));
+            }
+        }
+    }
+#else
+    void lerpLanes(const float* from, const float* to, const float factor, float* out, const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = from[i] + (to[i] - from[i]) * factor;
+        }
+    }
+
+    template <typename T>
+    void nlerpLanes(const T* const from[4], const T* const to[4], const float factor, float* const out[4], const size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            float q[4];
+            auto lengthSquared = 0.0f;
+            for (auto c = 0; c < 4; ++c) {
+                const auto a = static_cast<float>(from[c][i]);
+                const auto b = static_cast<float>(to[c][i]);
+                q[c] = a + (b - a) * factor;
+                lengthSquared += q[c] * q[c];
+            }
+            const auto inverseLength = 1.0f / std::sqrt(lengthSquared);
+            for (auto c = 0; c < 4; ++c) {
+                out[c][i] = q[c] * inverseLength;
+            }
+        }
+    }
+#endif
+}
+
+void LocalPose::resize(const size_t size)
+{
+    for (auto component : { &positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ, &rotationW }) {
+        component->resize(size);
+    }
+}
+
+AnimationClip::AnimationClip(const aiAnimation& animation, const bool quantizeRotations)
+{
+    channelCount = animation.mNumChannels;
+    stride = (channelCount + LANES - 1) / LANES * LANES;
+    ticksPerSecond = animation.mTicksPerSecond > 0 ? animation.mTicksPerSecond : 25.0;
+    duration = static_cast<float>(animation.mDuration / ticksPerSecond);
+    quantized = quantizeRotations;
+
+    // The spacing is stretched a little so the last sample lands exactly on the end of the clip
+    const auto intervals = static_cast<unsigned int>(std::ceil(duration * constants::ANIMATION_SAMPLE_RATE));
+    sampleCount = intervals + 1;
+    sampleRate = duration > 0.0f ? intervals / duration : 0.0f;
+
+    // Unanimated components and padding stay at the identity
+    const auto size = static_cast<size_t>(sampleCount) * stride;
+    positionX.assign(size, 0.0f);
+    positionY.assign(size, 0.0f);
+    positionZ.assign(size, 0.0f);
+    if (quantized) {
+        packedRotationX.assign(size, 0);
+        packedRotationY.assign(size, 0);
+        packedRotationZ.assign(size, 0);
+        packedRotationW.assign(size, packComponent(1.0f));
+    } else {
+        rotationX.assign(size, 0.0f);
+        rotationY.assign(size, 0.0f);
+        rotationZ.assign(size, 0.0f);
+        rotationW.assign(size, 1.0f);
+    }
+    channelNames.resize(channelCount);
+    positionAnimated.assign(channelCount, 0);
+    rotationAnimated.assign(channelCount, 0);
+    for (size_t i = 0; i < channelCount; ++i) {
+        bakeChannel(*animation.mChannels[i], i);
+    }
+}
+
+void AnimationClip::bakeChannel(const aiNodeAnim& channel, const size_t index)
+{
+    channelNames[index] = channel.mNodeName.C_Str();
+    positionAnimated[index] = channel.mNumPositionKeys > 0;
+    rotationAnimated[index] = channel.mNumRotationKeys > 0;
+
+    unsigned int positionCursor = 0;
+    unsigned int rotationCursor = 0;
+    aiQuaternion previousRotation;
+    for (auto sample = 0u; sample < sampleCount; ++sample) {
+        const auto ticks = sampleRate > 0.0f ? sample / static_cast<double>(sampleRate) * ticksPerSecond : 0.0;
+        const auto offset = static_cast<size_t>(sample) * stride + index;
+
+        if (positionAnimated[index]) {
+            const auto keys = channel.mPositionKeys;
+            const auto count = channel.mNumPositionKeys;
+            const auto key = findKey(keys, count, ticks, positionCursor);
+            auto value = keys[std::min(key, count - 1)].mValue;
+            if (key + 1 < count && keys[key + 1].mTime > keys[key].mTime) {
+                const auto factor = std::max(0.0, std::min(1.0, (ticks - keys[key].mTime) / (keys[key + 1].mTime - keys[key].mTime)));
+                value = keys[key].mValue + static_cast<float>(factor) * (keys[key + 1].mValue - keys[key].mValue);
+            }
+            positionX[offset] = value.x;
+            positionY[offset] = value.y;
+            positionZ[offset] = value.z;
+        }
+
+        if (rotationAnimated[index]) {
+            const auto keys = channel.mRotationKeys;
+            const auto count = channel.mNumRotationKeys;
+            const auto key = findKey(keys, count, ticks, rotationCursor);
+            auto value = keys[std::min(key, count - 1)].mValue;
+            if (key + 1 < count && keys[key + 1].mTime > keys[key].mTime) {
+                const auto factor = std::max(0.0, std::min(1.0, (ticks - keys[key].mTime) / (keys[key + 1].mTime - keys[key].mTime)));
+                aiQuaternion::Interpolate(value, keys[key].mValue, keys[key + 1].mValue, static_cast<float>(factor));
+            }
+            value.Normalize();
+            // q and -q are the same rotation, pick the one closest to the previous sample so nlerp takes the short way
+            if (sample > 0 && value.x * previousRotation.x + value.y * previousRotation.y + value.z * previousRotation.z
+                              + value.w * previousRotation.w < 0.0f) {
+                value = aiQuaternion(-value.w, -value.x, -value.y, -value.z);
+            }
+            previousRotation = value;
+            if (quantized) {
+                packedRotationX[offset] = packComponent(value.x);
+                packedRotationY[offset] = packComponent(value.y);
+                packedRotationZ[offset] = packComponent(value.z);
+                packedRotationW[offset] = packComponent(value.w);
+            } else {
+                rotationX[offset] = value.x;
+                rotationY[offset] = value.y;
+                rotationZ[offset] = value.z;
+                rotationW[offset] = value.w;
+            }
+        }
+    }
+}
+
+size_t AnimationClip::getChannelCount() const
+{
+    return channelCount;
+}
+
+const std::string& AnimationClip::getChannelName(const size_t channel) const
+{
+    return channelNames[channel];
+}
+
+bool AnimationClip::animatesPosition(const size_t channel) const
+{
+    return positionAnimated[channel] != 0;
+}
+
+bool AnimationClip::animatesRotation(const size_t channel) const
+{
+    return rotationAnimated[channel] != 0;
+}
+
+float AnimationClip::getDuration() const
+{
+    return duration;
+}
+
+double AnimationClip::getTicksPerSecond() const
+{
+    return ticksPerSecond;
+}
+
+void AnimationClip::sample(const float time, LocalPose& pose) const
+{
+    if (pose.positionX.size() != stride) {
+        pose.resize(stride);
+    }
+    if (stride == 0) {
+        return;
+    }
+    const auto position = std::max(0.0f, std::min(time, duration)) * sampleRate;
+    const auto sample = std::min(static_cast<unsigned int>(position), sampleCount - 1);
+    const auto next = std::min(sample + 1, sampleCount - 1);
+    const auto factor = std::min(position - sample, 1.0f);
+    samplePositions(static_cast<size_t>(sample) * stride, static_cast<size_t>(next) * stride, factor, pose, 0, stride);
+    sampleRotations(static_cast<size_t>(sample) * stride, static_cast<size_t>(next) * stride, factor, pose, 0, stride);
+}
+
+size_t AnimationClip::sample(const float time, const std::vector<size_t>& channels, std::vector<std::uint8_t>& dueGroups,
+                             LocalPose& pose) const
+{
+    if (pose.positionX.size() != stride) {
+        pose.resize(stride);
+    }
+    if (stride == 0 || channels.empty()) {
+        return 0;
+    }
+    dueGroups.assign(stride / LANES, 0);
+    for (const auto channel : channels) {
+        dueGroups[channel / LANES] = 1;
+    }
+    const auto position = std::max(0.0f, std::min(time, duration)) * sampleRate;
+    const auto sample = std::min(static_cast<unsigned int>(position), sampleCount - 1);
+    const auto next = std::min(sample + 1, sampleCount - 1);
+    const auto factor = std::min(position - sample, 1.0f);
+    size_t evaluated = 0;
+    for (size_t group = 0; group < dueGroups.size();) {
+        if (!dueGroups[group]) {
+            ++group;
+            continue;
+        }
+        // Neighbouring due groups go in one run
+        auto end = group;
+        while (end < dueGroups.size() && dueGroups[end]) {
+            ++end;
+        }
+        const auto lane = group * LANES;
+        const auto count = (end - group) * LANES;
+        samplePositions(static_cast<size_t>(sample) * stride, static_cast<size_t>(next) * stride, factor, pose, lane, count);
+        sampleRotations(static_cast<size_t>(sample) * stride, static_cast<size_t>(next) * stride, factor, pose, lane, count);
+        evaluated += std::min(lane + count, channelCount) - lane;
+        group = end;
+    }
+    return evaluated;
+}
+
+void AnimationClip::samplePositions(const size_t first, const size_t second, const float factor, LocalPose& pose,
+                                    const size_t lane, const size_t count) const
+{
+    lerpLanes(&positionX[first + lane], &positionX[second + lane], factor, pose.positionX.data() + lane, count);
+    lerpLanes(&positionY[first + lane], &positionY[second + lane], factor, pose.positionY.data() + lane, count);
+    lerpLanes(&positionZ[first + lane], &positionZ[second + lane], factor, pose.positionZ.data() + lane, count);
+}
+
+void AnimationClip::sampleRotations(const size_t first, const size_t second, const float factor, LocalPose& pose,
+                                    const size_t lane, const size_t count) const
+{
+    float* const out[4] = { pose.rotationX.data() + lane, pose.rotationY.data() + lane, pose.rotationZ.data() + lane,
+                            pose.rotationW.data() + lane };
+    const auto a = first + lane;
+    const auto b = second + lane;
+    if (quantized) {
+        const std::int16_t* const from[4] = { &packedRotationX[a], &packedRotationY[a], &packedRotationZ[a], &packedRotationW[a] };
+        const std::int16_t* const to[4] = { &packedRotationX[b], &packedRotationY[b], &packedRotationZ[b], &packedRotationW[b] };
+        nlerpLanes(from, to, factor, out, count);
+    } else {
+        const float* const from[4] = { &rotationX[a], &rotationY[a], &rotationZ[a], &rotationW[a] };
+        const float* const to[4] = { &rotationX[b], &rotationY[b], &rotationZ[b], &rotationW[b] };
+        nlerpLanes(from, to, factor, out, count);
+    }
+}
+
+bool AnimationClip::isGameplay(const aiScene& scene, const aiAnimation& animation)
+{
+    for (auto i = 0u; i < animation.mNumChannels; ++i) {
+        const auto node = scene.mRootNode->FindNode(animation.mChannels[i]->mNodeName);
+        auto gameplay = false;
+        if (node != nullptr && node->mMetaData != nullptr && node->mMetaData->Get("gameplay", gameplay) && gameplay) {
+            return true;
+        }
+    }
+    return false;
+}
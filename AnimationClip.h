@@ -0,0 +1,96 @@
+#pragma once
+#include "Constants.h"
+#include <assimp/anim.h>
+#include <assimp/scene.h>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Local transform of every channel of a clip, one array per component so the sampler fills whole SIMD lanes.
+// Sized to the clip's padded channel count, entries past the last channel are padding.
+struct LocalPose {
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+    void resize(size_t size);
+};
+
+// An aiAnimation baked at load: every channel resampled at ANIMATION_SAMPLE_RATE into float arrays laid out
+// sample by sample, the channels of one sample next to each other. Sampling never searches for keys, the two
+// samples around a time are found by a multiplication and every channel blends with the same factor, so the
+// whole clip is evaluated with a handful of vector lerps and nlerps. Rotations can be stored as 16 bit
+// normalized integers, consecutive samples are kept in the same hemisphere so nlerp needs no sign fix.
+class AnimationClip {
+public:
+    explicit AnimationClip(const aiAnimation& animation, bool quantizeRotations = constants::ANIMATION_QUANTIZE_ROTATIONS);
+
+    size_t getChannelCount() const;
+    const std::string& getChannelName(size_t channel) const;
+    bool animatesPosition(size_t channel) const;
+    bool animatesRotation(size_t channel) const;
+    float getDuration() const; // seconds
+    double getTicksPerSecond() const;
+
+    // time in seconds, clamped to the clip
+    void sample(float time, LocalPose& pose) const;
+    // Only the lanes holding these channels, the rest of pose is left as it was. Returns the clip channels
+    // those lanes evaluated. dueGroups is scratch the caller keeps, so sampling every step doesn't allocate.
+    size_t sample(float time, const std::vector<size_t>& channels, std::vector<std::uint8_t>& dueGroups, LocalPose& pose) const;
+
+    // Whether a node the animation drives is tagged with a true "gameplay" property, such animations keep
+    // playing while off screen
+    static bool isGameplay(const aiScene& scene, const aiAnimation& animation);
+
+    // Segment [keys[i], keys[i + 1]) holding the time, count - 1 when it is past the last key. The segment of the
+    // previous lookup and the next few are tried first: baking walks forward a key or two per sample, so the
+    // binary search is left for jumps and very dense clips.
+    template <typename Key>
+    static unsigned int findKey(const Key* keys, unsigned int count, double time, unsigned int& cursor);
+
+private:
+    friend class ScenePack; // stores the baked arrays as they are
+
+    AnimationClip() = default;
+    void bakeChannel(const aiNodeAnim& channel, size_t index);
+    // count channels from lane, a multiple of the SIMD width
+    void samplePositions(size_t first, size_t second, float factor, LocalPose& pose, size_t lane, size_t count) const;
+    void sampleRotations(size_t first, size_t second, float factor, LocalPose& pose, size_t lane, size_t count) const;
+
+    size_t channelCount;
+    size_t stride; // channels rounded up to whole SIMD lanes
+    unsigned int sampleCount;
+    float sampleRate;
+    float duration;
+    double ticksPerSecond;
+    bool quantized;
+    std::vector<std::string> channelNames;
+    std::vector<std::uint8_t> positionAnimated;
+    std::vector<std::uint8_t> rotationAnimated;
+    // [sample * stride + channel]
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+    std::vector<std::int16_t> packedRotationX, packedRotationY, packedRotationZ, packedRotationW;
+};
+
+template <typename Key>
+unsigned int AnimationClip::findKey(const Key* keys, const unsigned int count, const double time, unsigned int& cursor)
+{
+    if (count < 2) {
+        return 0;
+    }
+    const auto last = count - 1;
+    if (cursor < last && (cursor == 0 || time >= keys[cursor].mTime)) {
+        const auto end = std::min(cursor + constants::KEYFRAME_CURSOR_LOOKAHEAD, last);
+        for (auto i = cursor; i < end; ++i) {
+            if (time < keys[i + 1].mTime) {
+                cursor = i;
+                return i;
+            }
+        }
+    }
+    const auto next = std::upper_bound(keys + 1, keys + count, time, [](const double t, const Key& key) {
+        return t < key.mTime;
+    });
+    cursor = static_cast<unsigned int>(next - (keys + 1));
+    return cursor;
+}
@@ -74,6 +74,11 @@ glm::mat4 Camera::getViewMatrix() const
     return glm::lookAt(getPos(), getPos() + cameraFront, getCameraUp());
 }
 
+glm::mat4 Camera::getProjectionMatrix() const
+{
+    return glm::perspective(horizontalFOV, screenWidth / screenHeight, constants::NEAR_RENDER_PLANE, constants::FAR_RENDER_PLANE);
+}
+
 void Camera::objectMounted()
 {
     parentTransform = getParent()->getTransform();
@@ -21,6 +21,7 @@ public:
     glm::vec3 getCameraRight() const;
     glm::vec3 getCameraFront() const;
     glm::mat4 getViewMatrix() const;
+    glm::mat4 getProjectionMatrix() const;
 
     void objectMounted() override;
 
@@ -27,10 +27,15 @@ void Component::shadowMappingRender(const shared_ptr<ShaderFastMeshRender>& dept
 
 void Component::update() {}
 
+vector<shared_ptr<GameObject>> Component::getUpdateDependencies()
+{
+    return {};
+}
+
 void Component::objectMounted() {}
 
-void Component::render() {}
+void Component::render(const RenderView& view) {}
 
-void Component::lateRender() {}
+void Component::lateRender(const RenderView& view) {}
 
 Component::~Component() = default;
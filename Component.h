@@ -2,11 +2,13 @@
 #include <string>
 #include "Constants.h"
 #include <memory>
+#include <vector>
 
 using namespace std;
 
 class GameObject;
 class ShaderFastMeshRender;
+class RenderView;
 
 class Component : public enable_shared_from_this<Component> {
 public:
@@ -15,9 +17,12 @@ public:
     shared_ptr<GameObject> getParent() const;
     string getName() const;
     virtual void shadowMappingRender(const shared_ptr<ShaderFastMeshRender>& depthShader);
-    virtual void render();
-    virtual void lateRender();
+    virtual void render(const RenderView& view);
+    virtual void lateRender(const RenderView& view);
     virtual void update();
+    // Objects other than the one being updated whose state update() reads or writes. A component shared by
+    // several objects reports the object it keeps its state on. Parallel update never runs these concurrently.
+    virtual vector<shared_ptr<GameObject>> getUpdateDependencies();
     virtual void objectMounted();
     virtual ComponentKey getComponentKey() = 0;
     virtual ~Component();
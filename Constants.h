@@ -4,7 +4,10 @@ enum ShaderType {
     MaterialDefaultShader,
     SkyBoxShader,
     FastMeshRenderShader,
-    WaterShader
+    WaterShader,
+    DepthPyramidShader,
+    ImpostorShader,
+    ImpostorBakeShader
 };
 
 enum ComponentKey {
@@ -15,13 +18,18 @@ enum ComponentKey {
     CameraComponent,
     TransformComponent,
     SkyBoxComponent,
-    ObjectAnimationComponent
+    ObjectAnimationComponent,
+    HlodComponent
 };
 
 namespace constants {
     const int SCREEN_WIDTH = 1280;
     const int SCREEN_HEIGHT = 720;
-    const int SCREEN_FPS = 60;
+    const int SCREEN_FPS = 60; // render rate cap, the simulation runs at SIMULATION_STEP_RATE regardless
+    static const double SIMULATION_STEP_RATE = 60.0; // fixed updates per second
+    static const double MAX_FRAME_SECONDS = 0.25; // longest frame the simulation catches up on
+    static const float MAIN_CAMERA_SPEED = 900.0f; // units per second at speed 1
+    static const float WATER_WAVE_PERIOD = 20.0f; // seconds for the distortion to scroll through once
 
     const unsigned int SHADOW_MAPS_WIDTH = 2048, SHADOW_MAPS_HEIGHT = 2048;
     const unsigned int WATER_MAPS_WIDTH = 1024, WATER_MAPS_HEIGHT = 1024;
@@ -33,4 +41,75 @@ namespace constants {
     static const int WATER_DISTORTION_MAP_GL_PLACE = 7;
     static const int WATER_NORMAL_MAP_GL_PLACE = 8;
     static const int GENERIC_MATERIAL_GL_PLACE = 8;
+    static const int MULTI_VIEW_MAP_GL_PLACE = 9;
+    static const int SCENE_COLOR_MAP_GL_PLACE = 10;
+    static const int SCENE_DEPTH_MAP_GL_PLACE = 11;
+    static const int DEPTH_PYRAMID_GL_PLACE = 12;
+    static const int SKYBOX_MAP_GL_PLACE = 13;
+    static const int IMPOSTOR_COLOR_GL_PLACE = 14;
+    static const int IMPOSTOR_NORMAL_DEPTH_GL_PLACE = 15;
+    static const int BONE_PALETTE_BINDING = 0; // uniform block binding point of the skinning palette
+    static const unsigned int MAX_SKIN_BONES = 128; // size of the BonePalette block in the vertex shaders
+    // Meshes upload 16 byte vertices (quantized position, octahedral normal, half float UVs) and 16 bit indices
+    // when they have few enough vertices, instead of 32 byte float vertices and 32 bit indices
+    static const bool COMPACT_VERTEX_FORMAT = true;
+    static const bool OPTIMIZE_MESHES = true; // reorder triangles and vertices when cooking, see MeshOptimizer
+    static const unsigned int VERTEX_CACHE_SIZE = 16; // post transform cache entries the optimizer plans for
+    static const float OVERDRAW_THRESHOLD = 1.05f; // vertex cache efficiency given up to reduce overdraw
+    // Levels of detail cooked per mesh, full one included, each simplified to LOD_REDUCTION of the one before
+    // until the surface would move more than LOD_MAX_ERROR of the bounds diagonal
+    static const unsigned int LOD_COUNT = 4;
+    static const float LOD_REDUCTION = 0.5f;
+    static const float LOD_MAX_ERROR = 0.05f;
+    // Projected error in pixels each pass accepts, and the margin around it before a level is left
+    static const float LOD_PIXEL_ERROR = 1.0f;
+    static const float LOD_SHADOW_PIXEL_ERROR = 4.0f;
+    static const float LOD_WATER_PIXEL_ERROR = 2.0f;
+    static const float LOD_HYSTERESIS = 0.25f;
+    // Levels of detail are cut into clusters of nearby triangles, each culled against the view frustum and by its
+    // normal cone before the visible ones are drawn with one multi draw
+    static const bool CLUSTER_CULLING = true;
+    static const unsigned int CLUSTER_MAX_VERTICES = 64;
+    static const unsigned int CLUSTER_MAX_TRIANGLES = 124;
+    // Static meshes are grouped by cells of HLOD_CELL_SIZE, each group of HLOD_MIN_MEMBERS or more merged into a
+    // proxy with HLOD_REDUCTION of its triangles that passes draw instead of the group beyond HLOD_DISTANCE
+    static const bool HLOD_PROXIES = true;
+    static const float HLOD_CELL_SIZE = 2000.0f;
+    static const unsigned int HLOD_MIN_MEMBERS = 2;
+    static const float HLOD_REDUCTION = 0.25f;
+    static const float HLOD_MAX_ERROR = 0.02f;
+    static const float HLOD_DISTANCE = 4000.0f;
+    static const float HLOD_HYSTERESIS = 0.1f;
+    // Meshes are baked from IMPOSTOR_FRAMES x IMPOSTOR_FRAMES directions over the whole sphere into one atlas
+    // layer each, and the main and water passes draw a quad instead of any mesh smaller on screen than
+    // IMPOSTOR_SCREEN_SIZE. Layers are given out in scene order up to IMPOSTOR_MAX_COUNT.
+    static const bool IMPOSTORS = true;
+    static const int IMPOSTOR_FRAMES = 8;
+    static const int IMPOSTOR_FRAME_SIZE = 32; // pixels
+    static const int IMPOSTOR_MIP_LEVELS = 3; // past that a frame bleeds into its neighbours
+    static const int IMPOSTOR_MAX_COUNT = 128;
+    static const float IMPOSTOR_SCREEN_SIZE = 0.04f;
+    static const float IMPOSTOR_HYSTERESIS = 0.2f;
+    // Decoded texture bytes handed to GL per frame while the scene loads, larger images take several frames
+    static const unsigned int TEXTURE_UPLOAD_BUDGET = 4 * 1024 * 1024;
+    // Textures nothing uses any more stay cached for the next load until all of them take more than this
+    static const unsigned int TEXTURE_CACHE_BUDGET = 256 * 1024 * 1024;
+    static const int DRAW_LIST_CHUNK_SIZE = 64; // meshes culled and packed per draw recording job
+    static const int UPDATE_JOB_MIN_OBJECTS = 32; // smallest subtree parallel update hands to a job
+    static const int UPDATE_BENCHMARK_OBJECTS = 20000;
+    static const int UPDATE_BENCHMARK_FRAMES = 200;
+    static const unsigned int KEYFRAME_CURSOR_LOOKAHEAD = 4; // key segments tried linearly before a binary search
+    static const unsigned int KEYFRAME_BENCHMARK_KEYS = 20000;
+    static const int KEYFRAME_BENCHMARK_LOOKUPS = 100000;
+    static const float ANIMATION_SAMPLE_RATE = 30.0f; // baked clip samples per second, at least
+    static const bool ANIMATION_QUANTIZE_ROTATIONS = true; // 16 bit rotation components in baked clips
+    static const float ANIMATION_LOD_NEAR_SIZE = 0.2f; // screen height fraction animated every step
+    static const float ANIMATION_LOD_FAR_SIZE = 0.05f; // below this, every ANIMATION_LOD_FAR_INTERVAL steps
+    static const unsigned int ANIMATION_LOD_MID_INTERVAL = 2;
+    static const unsigned int ANIMATION_LOD_FAR_INTERVAL = 4;
+
+    // Water reflection (layer 0) and refraction (layer 1) rendered in one layered pass
+    static const int MULTI_VIEW_COUNT = 2;
+    static const int MULTI_VIEW_REFLECTION_LAYER = 0;
+    static const int MULTI_VIEW_REFRACTION_LAYER = 1;
 } // namespace constants
@@ -61,6 +61,7 @@ in VS_OUT {
     vec3 Normal;
     vec2 TexCoords;
     vec4 FragPosShadowLightSpace;
+    vec3 ViewPos; // the eye of the view this fragment is drawn for
 } fs_in;
 
 uniform int pointLightCount;
@@ -69,7 +70,6 @@ uniform int directionalLightCount;
 
 uniform sampler2D shadowMap;
 
-uniform vec3 viewPos;
 uniform DirLight dirLights[MAX_LIGHT_COUNT];
 uniform PointLight pointLights[MAX_LIGHT_COUNT];
 uniform SpotLight spotLights[MAX_LIGHT_COUNT];
@@ -84,7 +84,7 @@ void main()
 {    
     // properties
     vec3 norm = normalize(fs_in.Normal);
-    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+    vec3 viewDir = normalize(fs_in.ViewPos - fs_in.FragPos);
     
     // == =====================================================
     // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
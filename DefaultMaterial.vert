@@ -2,6 +2,8 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in uvec4 aBoneIds;
+layout (location = 4) in vec4 aBoneWeights;
 
 
 out VS_OUT {
@@ -9,22 +11,62 @@ out VS_OUT {
     vec3 Normal;
     vec2 TexCoords;
     vec4 FragPosShadowLightSpace;
+    vec3 ViewPos; // the eye of the view this fragment is drawn for
 } vs_out;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform vec3 viewPos;
 uniform mat4 shadowLightSpaceMatrix;
 
 uniform vec4 clippingPlane;
 
+// Size kept in sync with constants::MAX_SKIN_BONES
+layout (std140) uniform BonePalette {
+    mat4 bones[128];
+};
+uniform bool skinned;
+
+// Compact meshes store positions as 16 bit fractions of their bounds, float ones get an identity decode
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+uniform bool compactVertex;
+
+// Compact normals are octahedral encoded in xy
+vec3 decodeNormal()
+{
+    if (!compactVertex) {
+        return aNormal;
+    }
+    vec3 n = vec3(aNormal.xy, 1.0 - abs(aNormal.x) - abs(aNormal.y));
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
+
+// Blend of the bone matrices, the weight short of 1 stays with the mesh's own transform
+mat4 skinMatrix()
+{
+    if (!skinned) {
+        return mat4(1.0);
+    }
+    return bones[aBoneIds.x] * aBoneWeights.x + bones[aBoneIds.y] * aBoneWeights.y
+        + bones[aBoneIds.z] * aBoneWeights.z + bones[aBoneIds.w] * aBoneWeights.w
+        + mat4(1.0) * (1.0 - dot(aBoneWeights, vec4(1.0)));
+}
+
 void main()
 {
-    vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
-    vs_out.Normal = transpose(inverse(mat3(model))) * aNormal;
+    vec3 position = positionOffset + aPos * positionScale;
+    mat4 skinnedModel = model * skinMatrix();
+    vs_out.FragPos = vec3(skinnedModel * vec4(position, 1.0));
+    vs_out.Normal = transpose(inverse(mat3(skinnedModel))) * decodeNormal();
     vs_out.TexCoords = aTexCoords;
     vs_out.FragPosShadowLightSpace = shadowLightSpaceMatrix * vec4(vs_out.FragPos, 1.0);
-	vec4 worldPosition = model * vec4(aPos, 1.0);
+    vs_out.ViewPos = viewPos;
+	vec4 worldPosition = vec4(vs_out.FragPos, 1.0);
 	gl_ClipDistance[0] = dot(worldPosition, clippingPlane);
     gl_Position = projection * view * worldPosition;
 }
\ No newline at end of file
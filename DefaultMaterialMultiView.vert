@@ -0,0 +1,63 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in uvec4 aBoneIds;
+layout (location = 4) in vec4 aBoneWeights;
+
+// World space only, DefaultMaterialMultiView.geom projects once per view layer
+out VS_WORLD {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+    vec4 FragPosShadowLightSpace;
+} vs_out;
+
+uniform mat4 model;
+uniform mat4 shadowLightSpaceMatrix;
+
+// Size kept in sync with constants::MAX_SKIN_BONES
+layout (std140) uniform BonePalette {
+    mat4 bones[128];
+};
+uniform bool skinned;
+
+// Compact meshes store positions as 16 bit fractions of their bounds, float ones get an identity decode
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+uniform bool compactVertex;
+
+// Compact normals are octahedral encoded in xy
+vec3 decodeNormal()
+{
+    if (!compactVertex) {
+        return aNormal;
+    }
+    vec3 n = vec3(aNormal.xy, 1.0 - abs(aNormal.x) - abs(aNormal.y));
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
+
+// Blend of the bone matrices, the weight short of 1 stays with the mesh's own transform
+mat4 skinMatrix()
+{
+    if (!skinned) {
+        return mat4(1.0);
+    }
+    return bones[aBoneIds.x] * aBoneWeights.x + bones[aBoneIds.y] * aBoneWeights.y
+        + bones[aBoneIds.z] * aBoneWeights.z + bones[aBoneIds.w] * aBoneWeights.w
+        + mat4(1.0) * (1.0 - dot(aBoneWeights, vec4(1.0)));
+}
+
+void main()
+{
+    vec3 position = positionOffset + aPos * positionScale;
+    mat4 skinnedModel = model * skinMatrix();
+    vs_out.FragPos = vec3(skinnedModel * vec4(position, 1.0));
+    vs_out.Normal = transpose(inverse(mat3(skinnedModel))) * decodeNormal();
+    vs_out.TexCoords = aTexCoords;
+    vs_out.FragPosShadowLightSpace = shadowLightSpaceMatrix * vec4(vs_out.FragPos, 1.0);
+    gl_Position = vec4(vs_out.FragPos, 1.0);
+}
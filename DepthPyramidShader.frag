@@ -0,0 +1,37 @@
+#version 330 core
+layout(location = 0) out float MinDepth;
+
+// Only the previous level is visible (base level = max level), so lod 0 reads it
+uniform sampler2D previousLevel;
+uniform ivec2 previousLevelSize;
+uniform bool firstLevel;
+
+float fetchDepth(ivec2 coords)
+{
+    return texelFetch(previousLevel, clamp(coords, ivec2(0), previousLevelSize - 1), 0).r;
+}
+
+void main()
+{
+    ivec2 coords = ivec2(gl_FragCoord.xy);
+    if (firstLevel) {
+        MinDepth = fetchDepth(coords);
+        return;
+    }
+    ivec2 source = coords * 2;
+    float depth = min(min(fetchDepth(source), fetchDepth(source + ivec2(1, 0))),
+                      min(fetchDepth(source + ivec2(0, 1)), fetchDepth(source + ivec2(1, 1))));
+    // odd sizes: the last texel row/column of the previous level folds into the border texels
+    bool extraColumn = (previousLevelSize.x & 1) != 0 && source.x == previousLevelSize.x - 3;
+    bool extraRow = (previousLevelSize.y & 1) != 0 && source.y == previousLevelSize.y - 3;
+    if (extraColumn) {
+        depth = min(depth, min(fetchDepth(source + ivec2(2, 0)), fetchDepth(source + ivec2(2, 1))));
+    }
+    if (extraRow) {
+        depth = min(depth, min(fetchDepth(source + ivec2(0, 2)), fetchDepth(source + ivec2(1, 2))));
+    }
+    if (extraColumn && extraRow) {
+        depth = min(depth, fetchDepth(source + ivec2(2, 2)));
+    }
+    MinDepth = depth;
+}
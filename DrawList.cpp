@@ -0,0 +1,130 @@
+#include "DrawList.h"
+#include "Mesh.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const std::uint64_t LATE_DRAW_BIT = 1ull << 63;
+
+    // Positive floats keep their order when compared as unsigned integers
+    std::uint32_t depthBits(const float depth)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &depth, sizeof bits);
+        return bits;
+    }
+}
+
+DrawList::DrawList(const RenderView& view)
+    : view(view) {}
+
+const RenderView& DrawList::getView() const
+{
+    return view;
+}
+
+void DrawList::beginRecording(const int chunkCount)
+{
+    chunks.resize(chunkCount);
+    chunkRanges.resize(chunkCount);
+    for (auto& chunk : chunks) {
+        chunk.clear();
+    }
+    for (auto& chunk : chunkRanges) {
+        chunk.clear();
+    }
+    impostors.clear();
+}
+
+void DrawList::recordChunk(const int chunk, const std::vector<std::shared_ptr<Mesh>>& meshes, const std::vector<glm::mat4>& models,
+                           const std::vector<std::uint8_t>& hidden, const size_t begin, const size_t end)
+{
+    auto& out = chunks[chunk];
+    auto& outRanges = chunkRanges[chunk];
+    for (auto i = begin; i < end; ++i) {
+        const auto& mesh = meshes[i];
+        if (mesh->doNotRender || (i < hidden.size() && hidden[i])) {
+            continue;
+        }
+        DrawCommand command;
+        command.model = models[i];
+        if (!view.isVisible(*mesh, command.model)) {
+            continue;
+        }
+        command.mesh = mesh.get();
+        command.drawable = i;
+        const auto screenSize = view.getScreenSize(*mesh, command.model);
+        if (view.isMultiView()) {
+            // One draw feeds every layer: each layer's pass keeps its own hysteresis and the finest level is drawn
+            command.lod = mesh->selectLod(screenSize, view.getLayerLodPass(0));
+            for (auto layer = 1; layer < constants::MULTI_VIEW_COUNT; ++layer) {
+                command.lod = std::min(command.lod, mesh->selectLod(screenSize, view.getLayerLodPass(layer)));
+            }
+        } else {
+            command.lod = mesh->selectLod(screenSize, view.getLodPass());
+        }
+        command.rangeBegin = outRanges.size();
+        command.rangeCount = mesh->cullClusters(view, command.model, command.lod, outRanges);
+        if (command.rangeCount == 0) {
+            continue;
+        }
+        const auto depth = glm::length(glm::vec3(command.model[3]) - view.getPosition());
+        if (mesh->renderInLateRender) {
+            // back to front, no state grouping
+            command.sortKey = LATE_DRAW_BIT | ~depthBits(depth);
+        } else {
+            // grouped by program, front to back inside each group
+            command.sortKey = (static_cast<std::uint64_t>(mesh->getStateKey() & 0x7FFFFFFF) << 32) | depthBits(depth);
+        }
+        out.push_back(command);
+    }
+}
+
+void DrawList::endRecording()
+{
+    size_t total = 0;
+    for (const auto& chunk : chunks) {
+        total += chunk.size();
+    }
+    commands.clear();
+    commands.reserve(total);
+    ranges.clear();
+    for (size_t chunk = 0; chunk < chunks.size(); ++chunk) {
+        for (auto command : chunks[chunk]) {
+            command.rangeBegin += ranges.size();
+            commands.push_back(command);
+        }
+        ranges.insert(ranges.end(), chunkRanges[chunk].begin(), chunkRanges[chunk].end());
+    }
+    std::sort(commands.begin(), commands.end(), [](const DrawCommand& a, const DrawCommand& b) {
+        return a.sortKey < b.sortKey;
+    });
+    lateBegin = std::lower_bound(commands.begin(), commands.end(), LATE_DRAW_BIT, [](const DrawCommand& command, const std::uint64_t key) {
+        return command.sortKey < key;
+    }) - commands.begin();
+}
+
+const std::vector<DrawCommand>& DrawList::getCommands() const
+{
+    return commands;
+}
+
+std::vector<size_t>& DrawList::getImpostors()
+{
+    return impostors;
+}
+
+const std::vector<size_t>& DrawList::getImpostors() const
+{
+    return impostors;
+}
+
+void DrawList::submit(const RenderView& view, const bool late) const
+{
+    const auto begin = late ? lateBegin : 0;
+    const auto end = late ? commands.size() : lateBegin;
+    for (auto i = begin; i < end; ++i) {
+        const auto& command = commands[i];
+        command.mesh->draw(view, command.model, &ranges[command.rangeBegin], command.rangeCount);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "RenderView.h"
+#include "Mesh.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct DrawCommand {
+    std::uint64_t sortKey;
+    Mesh* mesh;
+    glm::mat4 model;
+    size_t drawable; // index into the meshes the list was recorded from
+    unsigned int lod;
+    size_t rangeBegin; // the index ranges of the clusters that survived culling, in the list's range array
+    size_t rangeCount;
+};
+
+// Draws of one view, recorded off the GL thread: every chunk of the scene is culled, down to the clusters of
+// each mesh, and packed into its own command vector by a job, then merged and sorted so submission only binds
+// state and issues draw calls.
+class DrawList {
+public:
+    explicit DrawList(const RenderView& view);
+    const RenderView& getView() const;
+
+    void beginRecording(int chunkCount);
+    // models holds the world matrix of every mesh, in the same order, and hidden flags the meshes to leave out,
+    // empty when none are
+    void recordChunk(int chunk, const std::vector<std::shared_ptr<Mesh>>& meshes, const std::vector<glm::mat4>& models,
+                     const std::vector<std::uint8_t>& hidden, size_t begin, size_t end);
+    void endRecording();
+
+    void submit(const RenderView& view, bool late) const;
+    const std::vector<DrawCommand>& getCommands() const;
+    // Drawables this view shows as impostors instead, filled before the chunks are recorded
+    std::vector<size_t>& getImpostors();
+    const std::vector<size_t>& getImpostors() const;
+
+private:
+    RenderView view;
+    std::vector<std::vector<DrawCommand>> chunks;
+    std::vector<std::vector<Mesh::DrawRange>> chunkRanges;
+    std::vector<DrawCommand> commands;
+    std::vector<Mesh::DrawRange> ranges;
+    std::vector<size_t> impostors;
+    size_t lateBegin = 0;
+};
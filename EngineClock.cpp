@@ -0,0 +1,53 @@
+#include "EngineClock.h"
+#include <algorithm>
+#include <chrono>
+
+EngineClock::EngineClock(const double stepRate)
+{
+    stepSeconds = 1.0 / stepRate;
+}
+
+double EngineClock::now()
+{
+    const std::chrono::duration<double> time = std::chrono::steady_clock::now().time_since_epoch();
+    return time.count();
+}
+
+int EngineClock::advance()
+{
+    const auto frameTime = now();
+    if (lastFrameTime >= 0.0) {
+        // After a hitch (loading, a breakpoint) the simulation skips ahead instead of catching up step by step
+        accumulator += std::min(frameTime - lastFrameTime, constants::MAX_FRAME_SECONDS);
+    }
+    lastFrameTime = frameTime;
+    const auto steps = static_cast<int>(accumulator / stepSeconds);
+    accumulator -= steps * stepSeconds;
+    return steps;
+}
+
+// Called before every fixed update, possibly from the pipelined update thread
+void EngineClock::step()
+{
+    simulationTime += stepSeconds;
+}
+
+void EngineClock::setStepRate(const double stepRate)
+{
+    stepSeconds = 1.0 / stepRate;
+}
+
+double EngineClock::getStepSeconds() const
+{
+    return stepSeconds;
+}
+
+double EngineClock::getSimulationTime() const
+{
+    return simulationTime;
+}
+
+float EngineClock::getInterpolation() const
+{
+    return static_cast<float>(accumulator / stepSeconds);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "Constants.h"
+
+// The engine's one time source, on the monotonic high resolution clock. The simulation advances in fixed steps
+// of 1 / rate seconds whatever the frame rate: advance() turns the real time since the previous frame into the
+// number of steps to run and keeps the remainder, which is how far rendering interpolates between the last two
+// simulated states. Components read the step length and the simulation time, never the wall clock.
+class EngineClock {
+public:
+    explicit EngineClock(double stepRate = constants::SIMULATION_STEP_RATE);
+    static double now();
+
+    int advance();
+    void step();
+    void setStepRate(double stepRate);
+
+    double getStepSeconds() const;
+    double getSimulationTime() const;
+    float getInterpolation() const;
+
+private:
+    double stepSeconds;
+    double simulationTime = 0.0;
+    double accumulator = 0.0;
+    double lastFrameTime = -1.0;
+};
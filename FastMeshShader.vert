@@ -1,10 +1,34 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 3) in uvec4 aBoneIds;
+layout (location = 4) in vec4 aBoneWeights;
 
 uniform mat4 model;
 uniform mat4 matrixViewProjection;
 
+// Size kept in sync with constants::MAX_SKIN_BONES
+layout (std140) uniform BonePalette {
+    mat4 bones[128];
+};
+uniform bool skinned;
+
+// Compact meshes store positions as 16 bit fractions of their bounds, float ones get an identity decode
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+// Blend of the bone matrices, the weight short of 1 stays with the mesh's own transform
+mat4 skinMatrix()
+{
+    if (!skinned) {
+        return mat4(1.0);
+    }
+    return bones[aBoneIds.x] * aBoneWeights.x + bones[aBoneIds.y] * aBoneWeights.y
+        + bones[aBoneIds.z] * aBoneWeights.z + bones[aBoneIds.w] * aBoneWeights.w
+        + mat4(1.0) * (1.0 - dot(aBoneWeights, vec4(1.0)));
+}
+
 void main()
 {
-    gl_Position = matrixViewProjection * model * vec4(aPos, 1.0);
+    vec3 position = positionOffset + aPos * positionScale;
+    gl_Position = matrixViewProjection * model * skinMatrix() * vec4(position, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "FrameTask.h"
+
+FrameTask::FrameTask()
+    : thread(&FrameTask::threadLoop, this) {}
+
+FrameTask::~FrameTask()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void FrameTask::launch(const std::function<void()>& task)
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = task;
+        running = true;
+    }
+    wake.notify_one();
+}
+
+void FrameTask::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return !running; });
+}
+
+bool FrameTask::isDone()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return !running;
+}
+
+void FrameTask::threadLoop()
+{
+    for (;;) {
+        std::function<void()> current;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || running; });
+            if (stopping) {
+                return;
+            }
+            current = std::move(task);
+        }
+        current();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        done.notify_all();
+    }
+}
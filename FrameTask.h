@@ -0,0 +1,32 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// A single long lived thread that runs one task at a time next to the GL thread, for work that spans a whole
+// frame such as the next frame's update. Unlike JobSystem it doesn't block the caller: launch returns at once
+// and wait joins the task.
+class FrameTask {
+public:
+    FrameTask();
+    FrameTask(const FrameTask&) = delete;
+    FrameTask& operator=(const FrameTask&) = delete;
+    ~FrameTask();
+
+    void launch(const std::function<void()>& task);
+    void wait();
+    // Whether the last task launched has returned, without waiting for it
+    bool isDone();
+
+private:
+    void threadLoop();
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::function<void()> task;
+    bool running = false;
+    bool stopping = false;
+    std::thread thread; // last, the loop starts using the members above right away
+};
@@ -26,6 +26,19 @@ void GameObject::addChild(const shared_ptr<GameObject>& child)
     children.push_back(child);
 }
 
+void GameObject::reserveChildren(const size_t count)
+{
+    children.reserve(children.size() + count);
+}
+
+void GameObject::removeChildren(const unordered_set<const GameObject*>& removed)
+{
+    children.erase(remove_if(children.begin(),
+                             children.end(),
+                             [&removed](const shared_ptr<GameObject>& child) { return removed.count(child.get()) > 0; }),
+                   children.end());
+}
+
 shared_ptr<GameObject> GameObject::findChild(const string& name)
 {
     const auto it = find_if(children.begin(),
@@ -88,6 +101,12 @@ void GameObject::addComponent(const shared_ptr<Component>& comp)
     components.push_back(comp);
 }
 
+void GameObject::clearComponents()
+{
+    components.clear();
+    transform = nullptr;
+}
+
 shared_ptr<Component> GameObject::getComponentFirst(ComponentKey key)
 {
     const auto it = find_if(components.begin(),
@@ -114,12 +133,31 @@ void GameObject::callUpdate()
     for (const auto& child : children) {
         child->callUpdate();
     }
+    callLocalUpdate();
+}
+
+// The object's own part of callUpdate, SceneUpdater runs it once the children are done
+void GameObject::callLocalUpdate()
+{
     for (const auto& component : components) {
         component->update();
     }
     update();
 }
 
+vector<shared_ptr<GameObject>> GameObject::getUpdateDependencies() const
+{
+    vector<shared_ptr<GameObject>> result;
+    for (const auto& component : components) {
+        for (const auto& dependency : component->getUpdateDependencies()) {
+            if (dependency && dependency.get() != this) {
+                result.push_back(dependency);
+            }
+        }
+    }
+    return result;
+}
+
 void GameObject::callShadowMappingRender(const shared_ptr<ShaderFastMeshRender>& depthShader)
 {
     for (const auto& component : components) {
@@ -130,24 +168,24 @@ void GameObject::callShadowMappingRender(const shared_ptr<ShaderFastMeshRender>&
     }
 }
 
-void GameObject::callRender()
+void GameObject::callRender(const RenderView& view)
 {
     for (const auto& component : components) {
-        component->render();
+        component->render(view);
     }
-    render();
+    render(view);
     for (const auto& child : children) {
-        child->callRender();
+        child->callRender(view);
     }
 }
 
-void GameObject::callLateRender()
+void GameObject::callLateRender(const RenderView& view)
 {
     for (const auto& component : components) {
-        component->lateRender();
+        component->lateRender(view);
     }
     for (const auto& child : children) {
-        child->callLateRender();
+        child->callLateRender(view);
     }
 }
 
@@ -214,6 +252,22 @@ void GameObject::setCurrentCamera(const shared_ptr<Camera>& currentCamera)
     this->currentCamera = currentCamera;
 }
 
+void GameObject::setCommandBuffer(const shared_ptr<SceneCommandBuffer>& commandBuffer)
+{
+    for (const auto& child : children) {
+        child->setCommandBuffer(commandBuffer);
+    }
+    this->commandBuffer = commandBuffer;
+}
+
+void GameObject::setEngineClock(const shared_ptr<EngineClock>& engineClock)
+{
+    for (const auto& child : children) {
+        child->setEngineClock(engineClock);
+    }
+    this->engineClock = engineClock;
+}
+
 void GameObject::callObjectMounted()
 {
     for (const auto& component : components) {
@@ -227,7 +281,7 @@ void GameObject::callObjectMounted()
 
 void GameObject::update() {}
 
-void GameObject::render() {}
+void GameObject::render(const RenderView& view) {}
 
 void GameObject::mouseButton(const MouseButtonCode button, int xPos, int yPos) {}
 
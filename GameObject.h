@@ -6,6 +6,7 @@
 #include <memory>
 #include <SDL.h>
 #include <vector>
+#include <unordered_set>
 using namespace std;
 
 using KeyCode = SDL_Keycode;
@@ -24,19 +25,27 @@ class Light;
 class Camera;
 class Mesh;
 class ShaderFastMeshRender;
+class RenderView;
+class SceneCommandBuffer;
+class EngineClock;
 
 class GameObject : public enable_shared_from_this<GameObject> {
 public:
     explicit GameObject(const string& name, const shared_ptr<GameObject>& parent = nullptr);
+    // Structural edits aren't thread safe, while the scene is updating record them on commandBuffer instead
     void setParent(const shared_ptr<GameObject>& parent);
     shared_ptr<GameObject> getParent() const;
     void addChild(const shared_ptr<GameObject>& child);
+    void reserveChildren(size_t count);
+    void removeChildren(const unordered_set<const GameObject*>& removed);
     shared_ptr<GameObject> findChild(const string& name);
     vector<shared_ptr<GameObject>> getChildren() const;
     list<shared_ptr<GameObject>> getGlobalChildrenList();
     shared_ptr<GameObject> findObject(const string& name);
     string getName() const;
     void addComponent(const shared_ptr<Component>& comp);
+    // Drops every component, which also breaks the references they hold back to the object
+    void clearComponents();
 
     shared_ptr<Component> getComponentFirst(ComponentKey key);
 
@@ -49,9 +58,11 @@ public:
 
     //Events
     void callUpdate();
+    void callLocalUpdate();
+    vector<shared_ptr<GameObject>> getUpdateDependencies() const;
     void callShadowMappingRender(const shared_ptr<ShaderFastMeshRender>& depthShader);
-    void callRender();
-    void callLateRender();
+    void callRender(const RenderView& view);
+    void callLateRender(const RenderView& view);
     void callMouseButton(MouseButtonCode button, int xPos, int yPos);
     void callMouseMotionEvent(int x, int y);
     void callKeyboardKeyUp(KeyCode key);
@@ -61,15 +72,19 @@ public:
     void callOnCollisionExit(const shared_ptr<GameObject>& other);
     void setIllumination(const list<shared_ptr<Light>>& illumination);
     void setCurrentCamera(const shared_ptr<Camera>& currentCamera);
+    void setCommandBuffer(const shared_ptr<SceneCommandBuffer>& commandBuffer);
+    void setEngineClock(const shared_ptr<EngineClock>& engineClock);
     void callObjectMounted();
     //-------
     virtual ~GameObject();
     list<shared_ptr<Light>> illumination;
     shared_ptr<Camera> currentCamera;
+    shared_ptr<SceneCommandBuffer> commandBuffer;
+    shared_ptr<EngineClock> engineClock;
 
 private:
     virtual void update();
-    virtual void render();
+    virtual void render(const RenderView& view);
     virtual void mouseButton(MouseButtonCode button, int xPos, int yPos);
     virtual void mouseMotionEvent(int x, int y);
     virtual void keyboardKeyUp(KeyCode key);
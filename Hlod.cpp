@@ -0,0 +1,206 @@
+#include "Hlod.h"
+#include "GameObject.h"
+#include "Transform.h"
+#include "ShaderMaterialDefault.h"
+#include "ObjectAnimation.h"
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <unordered_map>
+
+Hlod::Hlod(const shared_ptr<GameObject>& parent)
+    : Component("hlod", parent) {}
+
+ComponentKey Hlod::getComponentKey()
+{
+    return HlodComponent;
+}
+
+void Hlod::addSource(const shared_ptr<Mesh>& mesh, const Mesh::Geometry& geometry)
+{
+    if (!constants::HLOD_PROXIES || geometry.skin) {
+        return;
+    }
+    Source source;
+    source.mesh = mesh;
+    // Decoded when the geometry comes compressed from a pack
+    source.vertices.resize(geometry.vertexCount);
+    for (auto i = 0u; i < geometry.vertexCount; ++i) {
+        source.vertices[i] = Mesh::readVertex(geometry, i);
+    }
+    const auto indexCount = geometry.lodCount > 0 ? geometry.lods[0].indexCount : geometry.indexCount;
+    const auto indexOffset = geometry.lodCount > 0 ? geometry.lods[0].indexOffset : 0;
+    source.indices.resize(indexCount);
+    for (auto i = 0u; i < indexCount; ++i) {
+        source.indices[i] = Mesh::readIndex(geometry, indexOffset + i);
+    }
+    sources.push_back(std::move(source));
+}
+
+bool Hlod::isAnimated(const shared_ptr<GameObject>& object) const
+{
+    for (auto current = object; current; current = current->getParent()) {
+        if (std::find(animatedNames.begin(), animatedNames.end(), current->getName()) != animatedNames.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Hlod::build(const shared_ptr<ShaderMaterialDefault>& shader)
+{
+    groups.clear();
+    animatedNames.clear();
+    if (!parent) {
+        sources.clear();
+        return;
+    }
+    for (const auto& component : parent->getComponentList(ObjectAnimationComponent)) {
+        const auto& clip = static_pointer_cast<ObjectAnimation>(component)->clip;
+        for (size_t channel = 0; channel < clip->getChannelCount(); ++channel) {
+            animatedNames.push_back(clip->getChannelName(channel));
+        }
+    }
+
+    // Static meshes small enough to belong to one cell, by cell
+    std::map<std::array<int, 3>, vector<size_t>> cells;
+    vector<glm::mat4> models(sources.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const auto& mesh = sources[i].mesh;
+        const auto object = mesh->getParent();
+        if (mesh->doNotRender || mesh->renderInLateRender || !object->getTransform() || isAnimated(object)) {
+            continue;
+        }
+        models[i] = object->getTransform()->getModelMatrix();
+        glm::vec3 worldMin, worldMax;
+        mesh->getWorldBounds(models[i], worldMin, worldMax);
+        if (glm::length(worldMax - worldMin) > constants::HLOD_CELL_SIZE) {
+            continue;
+        }
+        const auto center = (worldMin + worldMax) * (0.5f / constants::HLOD_CELL_SIZE);
+        const std::array<int, 3> cell = { { static_cast<int>(std::floor(center.x)), static_cast<int>(std::floor(center.y)),
+                                            static_cast<int>(std::floor(center.z)) } };
+        cells[cell].push_back(i);
+    }
+
+    auto sourceTriangles = size_t(0);
+    auto proxyTriangles = size_t(0);
+    for (const auto& cell : cells) {
+        if (cell.second.size() < constants::HLOD_MIN_MEMBERS) {
+            continue;
+        }
+        // Everything in world space, the proxy is placed at the origin
+        Mesh::CookedGeometry cooked;
+        Group group;
+        for (const auto i : cell.second) {
+            const auto& source = sources[i];
+            const auto normalMatrix = glm::transpose(glm::inverse(glm::mat3(models[i])));
+            const auto base = static_cast<unsigned int>(cooked.vertices.size());
+            for (auto vertex : source.vertices) {
+                vertex.position = glm::vec3(models[i] * glm::vec4(vertex.position, 1.0f));
+                const auto normal = normalMatrix * vertex.normal;
+                const auto length = glm::length(normal);
+                vertex.normal = length > 0.0f ? normal / length : vertex.normal;
+                cooked.vertices.push_back(vertex);
+            }
+            for (const auto index : source.indices) {
+                cooked.indices.push_back(base + index);
+            }
+            group.members.push_back(source.mesh.get());
+        }
+        if (cooked.vertices.empty() || cooked.indices.empty()) {
+            continue;
+        }
+        sourceTriangles += cooked.indices.size() / 3;
+        vector<unsigned int> simplified;
+        MeshSimplifier::simplify(cooked.vertices, cooked.indices,
+                                 static_cast<size_t>(cooked.indices.size() / 3 * constants::HLOD_REDUCTION) * 3,
+                                 constants::HLOD_MAX_ERROR, simplified);
+        if (!simplified.empty()) {
+            cooked.indices.swap(simplified);
+        }
+        proxyTriangles += cooked.indices.size() / 3;
+
+        auto& geometry = cooked.geometry;
+        geometry.minPoints = cooked.vertices[0].position;
+        geometry.maxPoints = geometry.minPoints;
+        for (const auto& vertex : cooked.vertices) {
+            geometry.minPoints = glm::min(geometry.minPoints, vertex.position);
+            geometry.maxPoints = glm::max(geometry.maxPoints, vertex.position);
+        }
+        const auto name = "HLOD proxy " + std::to_string(groups.size());
+        Mesh::prepare(cooked, name);
+
+        const auto object = make_shared<GameObject>(name, parent);
+        const auto transform = make_shared<Transform>(object);
+        object->addComponent(transform);
+        transform->setRotation(0.0f, 0.0f, 0.0f, 1.0f);
+        transform->setScale(1.0f, 1.0f, 1.0f);
+        object->addComponent(shader);
+        const auto proxy = make_shared<Mesh>(geometry, object);
+        proxy->material = shader->material;
+        object->addComponent(proxy);
+        parent->addChild(object);
+
+        group.proxy = proxy.get();
+        group.center = (geometry.minPoints + geometry.maxPoints) * 0.5f;
+        group.radius = glm::length(geometry.maxPoints - geometry.minPoints) * 0.5f;
+        std::fill(std::begin(group.proxyShown), std::end(group.proxyShown), false);
+        groups.push_back(group);
+    }
+    sources.clear();
+    if (!groups.empty()) {
+        printf("HLOD: %zu proxies, %zu -> %zu triangles\n", groups.size(), sourceTriangles, proxyTriangles);
+    }
+}
+
+size_t Hlod::getGroupCount() const
+{
+    return groups.size();
+}
+
+void Hlod::bindDrawables(const vector<shared_ptr<Mesh>>& drawables)
+{
+    std::unordered_map<const Mesh*, int> memberGroups;
+    std::unordered_map<const Mesh*, int> proxyGroups;
+    for (auto g = 0u; g < groups.size(); ++g) {
+        for (const auto member : groups[g].members) {
+            memberGroups[member] = static_cast<int>(g);
+        }
+        proxyGroups[groups[g].proxy] = static_cast<int>(g);
+    }
+    drawableGroups.assign(drawables.size(), -1);
+    drawableProxies.assign(drawables.size(), -1);
+    for (auto i = 0u; i < drawables.size(); ++i) {
+        const auto member = memberGroups.find(drawables[i].get());
+        if (member != memberGroups.end()) {
+            drawableGroups[i] = member->second;
+        }
+        const auto proxy = proxyGroups.find(drawables[i].get());
+        if (proxy != proxyGroups.end()) {
+            drawableProxies[i] = proxy->second;
+        }
+    }
+}
+
+void Hlod::selectProxies(const RenderView& view, vector<std::uint8_t>& hidden)
+{
+    const auto pass = view.getLodPass();
+    for (auto& group : groups) {
+        const auto distance = glm::length(group.center - view.getPosition()) - group.radius;
+        const auto margin = group.proxyShown[pass] ? 1.0f - constants::HLOD_HYSTERESIS : 1.0f + constants::HLOD_HYSTERESIS;
+        group.proxyShown[pass] = distance > constants::HLOD_DISTANCE * margin;
+    }
+    hidden.assign(drawableGroups.size(), 0);
+    for (auto i = 0u; i < drawableGroups.size(); ++i) {
+        if (drawableGroups[i] >= 0 && groups[drawableGroups[i]].proxyShown[pass]) {
+            hidden[i] = 1;
+        }
+        if (drawableProxies[i] >= 0 && !groups[drawableProxies[i]].proxyShown[pass]) {
+            hidden[i] = 1;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "Component.h"
+#include "Mesh.h"
+#include "RenderView.h"
+#include <cstdint>
+#include <glm/glm.hpp>
+
+class ShaderMaterialDefault;
+
+// Hierarchical levels of detail for the far field. While loading, the static meshes are grouped by the grid
+// cell their bounds center falls in, and every group is merged into one proxy mesh in world space, simplified
+// and drawn with the scene material, which every mesh shares. Beyond HLOD_DISTANCE a pass draws the proxy
+// instead of the group, one draw where there were dozens. Lives on the scene root.
+class Hlod : public Component {
+public:
+    explicit Hlod(const shared_ptr<GameObject>& parent);
+    ComponentKey getComponentKey() override;
+
+    // Loading: geometry of a mesh that may join a proxy, copied since the loader's arrays don't outlive it
+    void addSource(const shared_ptr<Mesh>& mesh, const Mesh::Geometry& geometry);
+    // Once every object is placed: meshes under animated objects stay out, proxies are added under the root
+    void build(const shared_ptr<ShaderMaterialDefault>& shader);
+    size_t getGroupCount() const;
+
+    // The drawables as collected from the scene, proxies included
+    void bindDrawables(const vector<shared_ptr<Mesh>>& drawables);
+    // Per drawable, whether the view skips it: members of the groups it draws as their proxy and the proxies of
+    // the others. Every pass switches with a margin of its own, so groups near the distance don't flicker.
+    void selectProxies(const RenderView& view, vector<std::uint8_t>& hidden);
+
+private:
+    struct Source {
+        shared_ptr<Mesh> mesh;
+        vector<Mesh::Vertex> vertices;
+        vector<unsigned int> indices; // the full level
+    };
+
+    struct Group {
+        vector<const Mesh*> members;
+        const Mesh* proxy;
+        glm::vec3 center;
+        float radius;
+        bool proxyShown[LodPassCount];
+    };
+
+    bool isAnimated(const shared_ptr<GameObject>& object) const;
+
+    vector<Source> sources;
+    vector<Group> groups;
+    vector<string> animatedNames;
+    vector<int> drawableGroups; // per drawable, the group it's a member of or -1
+    vector<int> drawableProxies; // per drawable, the group it's the proxy of or -1
+};
@@ -0,0 +1,66 @@
+#version 330 core
+layout(location = 0) out vec4 color;
+
+struct DirLight {
+	float intensity;
+
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+#define MAX_LIGHT_COUNT 40
+#define VIEW_COUNT 2
+
+in GS_OUT {
+    vec2 FrameUV;
+    vec3 PlanePos;
+    flat vec3 AtlasOrigin;
+    flat vec3 DepthAxis;
+    flat mat3 NormalMatrix;
+    flat int ViewLayer;
+} fs_in;
+
+uniform sampler2DArray colorAtlas;
+uniform sampler2DArray normalDepthAtlas;
+uniform int frames;
+uniform mat4 viewProjections[VIEW_COUNT];
+uniform vec4 clippingPlanes[VIEW_COUNT];
+
+uniform int directionalLightCount;
+uniform DirLight dirLights[MAX_LIGHT_COUNT];
+uniform vec4 emissionColor;
+
+// Far away only, so directional lights without specular or shadows, the way DefaultMaterial.frag lights
+// diffuse mapped surfaces
+void main()
+{
+    if (any(lessThan(fs_in.FrameUV, vec2(0.0))) || any(greaterThan(fs_in.FrameUV, vec2(1.0)))) {
+        discard;
+    }
+    vec3 atlasCoords = vec3(fs_in.AtlasOrigin.xy + fs_in.FrameUV / frames, fs_in.AtlasOrigin.z);
+    vec4 albedo = texture(colorAtlas, atlasCoords);
+    if (albedo.a < 0.5) {
+        discard;
+    }
+    vec4 normalDepth = texture(normalDepthAtlas, atlasCoords);
+    vec3 position = fs_in.PlanePos + fs_in.DepthAxis * (normalDepth.w * 2.0 - 1.0);
+    if (dot(vec4(position, 1.0), clippingPlanes[fs_in.ViewLayer]) < 0.0) {
+        discard;
+    }
+    vec3 normal = normalize(fs_in.NormalMatrix * (normalDepth.xyz * 2.0 - 1.0));
+
+    vec4 result = vec4(0.0);
+    for (int i = 0; i < directionalLightCount && i < MAX_LIGHT_COUNT; i++) {
+        float diff = max(dot(normal, normalize(dirLights[i].direction)), 0.0);
+        vec3 ambient = (dirLights[i].ambient + vec3(0.3)) * albedo.rgb;
+        vec3 diffuse = dirLights[i].diffuse * diff * albedo.rgb;
+        result += vec4(ambient + diffuse, 1.0) * dirLights[i].intensity;
+    }
+    color = vec4(min(result.rgb + emissionColor.rgb, vec3(1.0)), 1.0);
+
+    vec4 clip = viewProjections[fs_in.ViewLayer] * vec4(position, 1.0);
+    gl_FragDepth = clip.z / clip.w * 0.5 + 0.5;
+}
@@ -0,0 +1,19 @@
+#version 330 core
+// One point per impostor, Impostor.geom expands it to a quad per view layer
+layout (location = 0) in mat4 aModel; // locations 0 to 3
+layout (location = 4) in vec4 aBounds; // model space center and radius
+layout (location = 5) in float aLayer;
+
+out VS_IMPOSTOR {
+    mat4 Model;
+    vec4 Bounds;
+    float Layer;
+} vs_out;
+
+void main()
+{
+    vs_out.Model = aModel;
+    vs_out.Bounds = aBounds;
+    vs_out.Layer = aLayer;
+    gl_Position = aModel * vec4(aBounds.xyz, 1.0);
+}
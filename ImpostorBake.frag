@@ -0,0 +1,24 @@
+#version 330 core
+layout(location = 0) out vec4 color;
+layout(location = 1) out vec4 normalDepth;
+
+in VS_OUT {
+    vec3 Normal;
+    vec2 TexCoords;
+    float Depth;
+} fs_in;
+
+uniform bool hasDiffuseMap;
+uniform sampler2D diffuseMap;
+uniform vec4 diffuseColor;
+
+// Unlit albedo, the impostor is lit where it's drawn. Depth is towards the frame's eye, in bounds radii.
+void main()
+{
+    vec4 albedo = diffuseColor;
+    if (hasDiffuseMap) {
+        albedo *= texture(diffuseMap, fs_in.TexCoords);
+    }
+    color = vec4(albedo.rgb, 1.0);
+    normalDepth = vec4(normalize(fs_in.Normal) * 0.5 + 0.5, clamp(fs_in.Depth * 0.5 + 0.5, 0.0, 1.0));
+}
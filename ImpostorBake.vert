@@ -0,0 +1,43 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+// Model space only, impostors are baked around the mesh's own bounds
+out VS_OUT {
+    vec3 Normal;
+    vec2 TexCoords;
+    float Depth;
+} vs_out;
+
+uniform mat4 viewProjection;
+uniform vec3 boundsCenter;
+uniform float boundsRadius;
+uniform vec3 frameDirection; // from the center towards the frame's eye
+
+// Compact meshes store positions as 16 bit fractions of their bounds, float ones get an identity decode
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+uniform bool compactVertex;
+
+// Compact normals are octahedral encoded in xy
+vec3 decodeNormal()
+{
+    if (!compactVertex) {
+        return aNormal;
+    }
+    vec3 n = vec3(aNormal.xy, 1.0 - abs(aNormal.x) - abs(aNormal.y));
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
+
+void main()
+{
+    vec3 position = positionOffset + aPos * positionScale;
+    vs_out.Normal = decodeNormal();
+    vs_out.TexCoords = aTexCoords;
+    vs_out.Depth = dot(position - boundsCenter, frameDirection) / boundsRadius;
+    gl_Position = viewProjection * vec4(position, 1.0);
+}
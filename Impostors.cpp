@@ -0,0 +1,250 @@
+#include "Impostors.h"
+#include "OpenGLImports.h"
+#include "Constants.h"
+#include "EngineClock.h"
+#include "Material.h"
+#include "Mesh.h"
+#include "ShaderImpostor.h"
+#include "ShaderImpostorBake.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <unordered_map>
+
+namespace {
+    // Same mapping as octDecode in Impostor.geom, which picks the frames back by direction
+    glm::vec3 octDecode(const glm::vec2& encoded)
+    {
+        auto n = glm::vec3(encoded, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+        if (n.z < 0.0f) {
+            const auto x = n.x;
+            n.x = (1.0f - std::abs(n.y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            n.y = (1.0f - std::abs(x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+        }
+        return glm::normalize(n);
+    }
+
+    GLuint createAtlas(const int size, const int layers)
+    {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        for (auto level = 0; level < constants::IMPOSTOR_MIP_LEVELS; ++level) {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, std::max(size >> level, 1), std::max(size >> level, 1), layers, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, constants::IMPOSTOR_MIP_LEVELS - 1);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        return texture;
+    }
+}
+
+Impostors::Impostors()
+{
+    shader = std::make_unique<ShaderImpostor>(nullptr);
+    bakeShader = std::make_unique<ShaderImpostorBake>(nullptr);
+
+    glGenBuffers(1, &instanceBuffer);
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    for (auto column = 0; column < 4; ++column) {
+        glEnableVertexAttribArray(column);
+        glVertexAttribPointer(column, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                              reinterpret_cast<void*>(offsetof(Instance, model) + column * sizeof(glm::vec4)));
+    }
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), reinterpret_cast<void*>(offsetof(Instance, bounds)));
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), reinterpret_cast<void*>(offsetof(Instance, layer)));
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Impostors::~Impostors()
+{
+    glDeleteTextures(1, &colorAtlas);
+    glDeleteTextures(1, &normalDepthAtlas);
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteVertexArrays(1, &vao);
+}
+
+void Impostors::bake(const std::vector<std::shared_ptr<Mesh>>& drawables, const std::shared_ptr<Material>& material)
+{
+    const auto start = EngineClock::now();
+    entries.clear();
+    auto skipped = 0;
+    for (const auto& mesh : drawables) {
+        // Skinned meshes change shape and late ones are blended, neither looks like a fixed picture of itself
+        if (mesh->isSkinned() || mesh->doNotRender || mesh->renderInLateRender) {
+            continue;
+        }
+        const auto radius = glm::length(mesh->maxPoints - mesh->minPoints) * 0.5f;
+        if (radius <= 0.0f) {
+            continue;
+        }
+        if (entries.size() == static_cast<size_t>(constants::IMPOSTOR_MAX_COUNT)) {
+            ++skipped;
+            continue;
+        }
+        Entry entry;
+        entry.mesh = mesh.get();
+        entry.center = (mesh->minPoints + mesh->maxPoints) * 0.5f;
+        entry.radius = radius;
+        std::fill(std::begin(entry.shown), std::end(entry.shown), false);
+        entries.push_back(entry);
+    }
+    bindDrawables(drawables);
+    if (entries.empty()) {
+        return;
+    }
+
+    const auto frameSize = constants::IMPOSTOR_FRAME_SIZE;
+    const auto size = constants::IMPOSTOR_FRAMES * frameSize;
+    const auto layers = static_cast<int>(entries.size());
+    colorAtlas = createAtlas(size, layers);
+    normalDepthAtlas = createAtlas(size, layers);
+
+    GLint oldViewport[4];
+    glGetIntegerv(GL_VIEWPORT, oldViewport);
+    GLfloat oldClearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, oldClearColor);
+    const auto blend = glIsEnabled(GL_BLEND);
+    glDisable(GL_BLEND);
+
+    GLuint frameBuffer;
+    GLuint depthBuffer;
+    glGenFramebuffers(1, &frameBuffer);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+    glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    const GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, drawBuffers);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+    bakeShader->use();
+    bakeShader->setMaterial(material);
+    for (auto layer = 0; layer < layers; ++layer) {
+        const auto& entry = entries[layer];
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, colorAtlas, 0, layer);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, normalDepthAtlas, 0, layer);
+        glViewport(0, 0, size, size);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // Orthographic, the bounds sphere fills the frame and its depth range
+        const auto projection = glm::ortho(-entry.radius, entry.radius, -entry.radius, entry.radius, entry.radius, 3.0f * entry.radius);
+        for (auto y = 0; y < constants::IMPOSTOR_FRAMES; ++y) {
+            for (auto x = 0; x < constants::IMPOSTOR_FRAMES; ++x) {
+                const auto cell = (glm::vec2(x, y) + 0.5f) / static_cast<float>(constants::IMPOSTOR_FRAMES) * 2.0f - 1.0f;
+                const auto direction = octDecode(cell);
+                const auto upHint = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+                const auto view = glm::lookAt(entry.center + direction * (2.0f * entry.radius), entry.center, upHint);
+                glViewport(x * frameSize, y * frameSize, frameSize, frameSize);
+                bakeShader->setFrame(projection * view, entry.center, entry.radius, direction);
+                entry.mesh->drawWith(*bakeShader);
+            }
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &frameBuffer);
+    glDeleteRenderbuffers(1, &depthBuffer);
+    for (const auto atlas : { colorAtlas, normalDepthAtlas }) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, atlas);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glViewport(oldViewport[0], oldViewport[1], oldViewport[2], oldViewport[3]);
+    glClearColor(oldClearColor[0], oldClearColor[1], oldClearColor[2], oldClearColor[3]);
+    if (blend) {
+        glEnable(GL_BLEND);
+    }
+    printf("Impostors: %d meshes baked into %dx%d atlas layers in %.1f ms", layers, size, size, (EngineClock::now() - start) * 1000.0);
+    if (skipped > 0) {
+        printf(", %d left out past IMPOSTOR_MAX_COUNT", skipped);
+    }
+    printf("\n");
+}
+
+void Impostors::setupLighting(const std::list<std::shared_ptr<Light>>& illumination, const std::shared_ptr<Material>& material) const
+{
+    shader->setupLighting(illumination, material ? material->emission : glm::vec4(0.0f));
+}
+
+size_t Impostors::getCount() const
+{
+    return entries.size();
+}
+
+void Impostors::bindDrawables(const std::vector<std::shared_ptr<Mesh>>& drawables)
+{
+    std::unordered_map<const Mesh*, int> meshEntries;
+    for (auto i = 0u; i < entries.size(); ++i) {
+        meshEntries[entries[i].mesh] = static_cast<int>(i);
+    }
+    drawableEntries.assign(drawables.size(), -1);
+    for (auto i = 0u; i < drawables.size(); ++i) {
+        const auto entry = meshEntries.find(drawables[i].get());
+        if (entry != meshEntries.end()) {
+            drawableEntries[i] = entry->second;
+        }
+    }
+}
+
+void Impostors::select(const RenderView& view, const std::vector<std::shared_ptr<Mesh>>& drawables,
+                       const std::vector<glm::mat4>& models, std::vector<std::uint8_t>& hidden, std::vector<size_t>& selected)
+{
+    const auto pass = view.getLodPass();
+    for (auto i = 0u; i < drawableEntries.size(); ++i) {
+        if (drawableEntries[i] < 0 || (i < hidden.size() && hidden[i]) || drawables[i]->doNotRender) {
+            continue;
+        }
+        auto& entry = entries[drawableEntries[i]];
+        const auto& mesh = *drawables[i];
+        const auto margin = entry.shown[pass] ? 1.0f + constants::IMPOSTOR_HYSTERESIS : 1.0f - constants::IMPOSTOR_HYSTERESIS;
+        entry.shown[pass] = view.getScreenSize(mesh, models[i]) < constants::IMPOSTOR_SCREEN_SIZE * margin;
+        if (!entry.shown[pass]) {
+            continue;
+        }
+        if (hidden.empty()) {
+            hidden.assign(drawables.size(), 0);
+        }
+        hidden[i] = 1;
+        if (view.isVisible(mesh, models[i])) {
+            selected.push_back(i);
+        }
+    }
+}
+
+void Impostors::draw(const RenderView& view, const std::vector<size_t>& selected, const std::vector<glm::mat4>& models)
+{
+    if (selected.empty()) {
+        return;
+    }
+    instances.clear();
+    for (const auto drawable : selected) {
+        const auto layer = drawableEntries[drawable];
+        const auto& entry = entries[layer];
+        instances.push_back(Instance{ models[drawable], glm::vec4(entry.center, entry.radius), static_cast<float>(layer), {} });
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Instance), instances.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE0 + constants::IMPOSTOR_COLOR_GL_PLACE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, colorAtlas);
+    glActiveTexture(GL_TEXTURE0 + constants::IMPOSTOR_NORMAL_DEPTH_GL_PLACE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, normalDepthAtlas);
+    shader->setup(view, constants::IMPOSTOR_COLOR_GL_PLACE, constants::IMPOSTOR_NORMAL_DEPTH_GL_PLACE);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(instances.size()));
+    glBindVertexArray(0);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "RenderView.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <vector>
+
+class Light;
+class Material;
+class Mesh;
+class ShaderImpostor;
+class ShaderImpostorBake;
+
+// Octahedral impostors for meshes too small on screen to be worth their triangles. Once loaded, every eligible
+// mesh is rendered from IMPOSTOR_FRAMES x IMPOSTOR_FRAMES directions spread over the sphere into a layer of two
+// atlases: unlit color with coverage, and model space normal with depth. The main and water passes then draw
+// all their distant meshes as one batch of points, expanded to camera facing quads that show the frame nearest
+// to the view direction, relit and written at the baked depth so they still intersect the scene.
+class Impostors {
+public:
+    Impostors();
+    ~Impostors();
+    // Needs the GL context, leaves the default framebuffer bound
+    void bake(const std::vector<std::shared_ptr<Mesh>>& drawables, const std::shared_ptr<Material>& material);
+    void setupLighting(const std::list<std::shared_ptr<Light>>& illumination, const std::shared_ptr<Material>& material) const;
+    size_t getCount() const;
+
+    // The drawables as collected from the scene
+    void bindDrawables(const std::vector<std::shared_ptr<Mesh>>& drawables);
+    // Takes the drawables that are small enough in this view out of its draw list: flags them in hidden, which
+    // grows to one flag per drawable if it was empty, and appends the visible ones to selected. Every pass
+    // switches with a margin of its own, so meshes near the switching size don't flicker.
+    void select(const RenderView& view, const std::vector<std::shared_ptr<Mesh>>& drawables,
+                const std::vector<glm::mat4>& models, std::vector<std::uint8_t>& hidden, std::vector<size_t>& selected);
+    // A single draw for all of them, into the framebuffer bound
+    void draw(const RenderView& view, const std::vector<size_t>& selected, const std::vector<glm::mat4>& models);
+
+private:
+    struct Entry {
+        const Mesh* mesh;
+        glm::vec3 center; // model space bounds sphere the frames were baked around
+        float radius;
+        bool shown[LodPassCount];
+    };
+
+    // One point of the batch, laid out for Impostor.vert
+    struct Instance {
+        glm::mat4 model;
+        glm::vec4 bounds;
+        float layer;
+        float padding[3];
+    };
+
+    std::vector<Entry> entries; // one per atlas layer
+    std::vector<int> drawableEntries; // per drawable, its entry or -1
+    std::vector<Instance> instances;
+    std::unique_ptr<ShaderImpostor> shader;
+    std::unique_ptr<ShaderImpostorBake> bakeShader;
+    unsigned int colorAtlas = 0;
+    unsigned int normalDepthAtlas = 0;
+    unsigned int instanceBuffer = 0;
+    unsigned int vao = 0;
+};
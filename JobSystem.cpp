@@ -0,0 +1,164 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace {
+    // Identifies the worker running on this thread, if any
+    thread_local const JobSystem* currentSystem = nullptr;
+    thread_local int currentWorker = -1;
+}
+
+JobSystem::JobGroup::JobGroup()
+{
+    pending = 0;
+}
+
+JobSystem::JobSystem(const unsigned int workerCount)
+{
+    queuedJobs = 0;
+    sleepingWorkers = 0;
+    for (auto i = 0u; i <= workerCount; ++i) {
+        queues.push_back(std::unique_ptr<JobQueue>(new JobQueue()));
+    }
+    for (auto i = 0u; i < workerCount; ++i) {
+        workers.emplace_back(&JobSystem::workerLoop, this, static_cast<int>(i));
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+unsigned int JobSystem::defaultWorkerCount()
+{
+    // One core stays with the thread that owns the GL context
+    const auto cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+}
+
+unsigned int JobSystem::getWorkerCount() const
+{
+    return static_cast<unsigned int>(workers.size());
+}
+
+void JobSystem::run(JobGroup& group, const std::function<void()>& job)
+{
+    group.pending.fetch_add(1);
+    auto& queue = *queues[currentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(Job{ job, &group });
+    }
+    queuedJobs.fetch_add(1);
+    // Sleepers count themselves before checking queuedJobs, so one of the two sides always sees the other
+    if (sleepingWorkers.load() > 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wake.notify_one();
+    }
+}
+
+void JobSystem::wait(JobGroup& group)
+{
+    const auto queue = currentQueue();
+    while (group.pending.load(std::memory_order_acquire) > 0) {
+        if (!runOneJob(queue)) {
+            // The remaining jobs are running on other threads
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::parallelFor(const int count, const std::function<void(int)>& job)
+{
+    if (count <= 0) {
+        return;
+    }
+    if (workers.empty() || count == 1) {
+        for (auto i = 0; i < count; ++i) {
+            job(i);
+        }
+        return;
+    }
+    // A few ranges per thread: cheap to schedule, still enough to steal when items cost unevenly
+    const auto rangeCount = std::min(count, static_cast<int>(queues.size()) * 4);
+    JobGroup group;
+    for (auto range = 0; range < rangeCount; ++range) {
+        const auto begin = static_cast<int>(static_cast<long long>(count) * range / rangeCount);
+        const auto end = static_cast<int>(static_cast<long long>(count) * (range + 1) / rangeCount);
+        run(group, [&job, begin, end] {
+            for (auto i = begin; i < end; ++i) {
+                job(i);
+            }
+        });
+    }
+    wait(group);
+}
+
+int JobSystem::currentQueue() const
+{
+    return currentSystem == this ? currentWorker : static_cast<int>(queues.size()) - 1;
+}
+
+bool JobSystem::runOneJob(const int queue)
+{
+    Job job;
+    if (!takeJob(queue, job)) {
+        return false;
+    }
+    job.function();
+    job.group->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+bool JobSystem::takeJob(const int queue, Job& job)
+{
+    const auto queueCount = static_cast<int>(queues.size());
+    const auto external = queueCount - 1;
+    // Own work newest first while it is still in cache, everything else oldest first
+    if (queue != external) {
+        auto& own = *queues[queue];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queuedJobs.fetch_sub(1);
+            return true;
+        }
+    }
+    for (auto i = 1; i <= queueCount; ++i) {
+        auto& victim = *queues[(queue + i) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queuedJobs.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::workerLoop(const int index)
+{
+    currentSystem = this;
+    currentWorker = index;
+    for (;;) {
+        if (runOneJob(index)) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        ++sleepingWorkers;
+        wake.wait(lock, [this] { return stopping || queuedJobs.load() > 0; });
+        --sleepingWorkers;
+        if (stopping) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool for frame work. Every worker keeps its own deque: jobs it spawns go to the back and are
+// taken from the back, idle workers steal from the front of the others. Threads outside the pool (the GL
+// thread, the pipelined update thread) submit to a shared queue. wait runs queued jobs until the group is
+// done instead of blocking, so jobs may spawn and wait on nested groups, and a pool without workers runs
+// everything on the waiting thread.
+class JobSystem {
+public:
+    // Counts the unfinished jobs of one batch
+    class JobGroup {
+    public:
+        JobGroup();
+        JobGroup(const JobGroup&) = delete;
+        JobGroup& operator=(const JobGroup&) = delete;
+    private:
+        friend class JobSystem;
+        std::atomic<int> pending;
+    };
+
+    explicit JobSystem(unsigned int workerCount = defaultWorkerCount());
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    ~JobSystem();
+
+    void run(JobGroup& group, const std::function<void()>& job);
+    void wait(JobGroup& group);
+    void parallelFor(int count, const std::function<void(int)>& job);
+    unsigned int getWorkerCount() const;
+    static unsigned int defaultWorkerCount();
+
+private:
+    struct Job {
+        std::function<void()> function;
+        JobGroup* group;
+    };
+
+    struct JobQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void workerLoop(int index);
+    int currentQueue() const;
+    bool runOneJob(int queue);
+    bool takeJob(int queue, Job& job);
+
+    // One per worker, the last one takes the jobs submitted from outside the pool
+    std::vector<std::unique_ptr<JobQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<int> queuedJobs;
+    std::atomic<int> sleepingWorkers;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
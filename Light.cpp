@@ -45,14 +45,12 @@ void Light::setupShadowMapping(const shared_ptr<ShaderFastMeshRender>& depthShad
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         depthShader->use();
         depthShader->setMatrixViewProjection(matrixViewProjection);
-        glCullFace(GL_FRONT);
     }
 }
 
 void Light::endShadowMapping() const
 {
     if (castShadows) {
-        glCullFace(GL_BACK);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         glViewport(0, 0, constants::SCREEN_WIDTH, constants::SCREEN_HEIGHT);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
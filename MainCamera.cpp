@@ -2,6 +2,7 @@
 #include "Camera.h"
 #include "Constants.h"
 #include "Transform.h"
+#include "EngineClock.h"
 #include "glm/gtx/rotate_vector.hpp"
 #include <glm/glm.hpp>
 
@@ -20,7 +21,7 @@ void MainCamera::update()
     auto t = getTransform();
     const auto front = normalize(glm::vec3(cam->getCameraFront().x, 0.0f, cam->getCameraFront().z));
     auto position = t->getPosition();
-    const auto velocity = getSpeed() * 15.0f;
+    const auto velocity = getSpeed() * MAIN_CAMERA_SPEED * static_cast<float>(engineClock->getStepSeconds());
     if (forward) position += front * velocity;
     if (backward) position -= front * velocity;
     if (left) position -= normalize(cross(front, cam->getCameraUp())) * velocity;
@@ -8,14 +8,139 @@
 #include "ShaderWater.h"
 #include "ShaderMaterialDefault.h"
 #include "Transform.h"
+#include "ScreenCapture.h"
+#include "RenderView.h"
+#include "RenderGraph.h"
+#include "DrawList.h"
+#include "Mesh.h"
+#include "SkyBox.h"
+#include "AnimationClip.h"
+#include "ObjectAnimation.h"
+#include "SceneCommandBuffer.h"
+#include "EngineClock.h"
+#include "Hlod.h"
+#include "Impostors.h"
+#include "TextureStreamer.h"
+#include "TextureCache.h"
 #include <cstdio>
+#include <algorithm>
+#include <random>
 #include <GL/glew.h>
 #include <GL/GLU.h>
 
+namespace {
+    const char* const SCENE_FILE = "DemoScene.fbx";
+    const char* const SCENE_PACK_FILE = "DemoScene.pack";
+}
+
+// What a load show() started has got to. The file is read and its meshes cooked on loadTask, the scene is
+// built on the GL thread between two frames, then the textures stream in while it renders.
+struct MainWindow::SceneLoad {
+    ScenePack pack; // open until the images decoded from it are streamed
+    bool fromPack = false;
+    const aiScene* imported = nullptr;
+    std::vector<Mesh::CookedGeometry> cookedMeshes;
+    double start = 0.0;
+    double importSeconds = 0.0;
+    double cookSeconds = 0.0;
+};
+
+void MainWindow::startLoading()
+{
+    sceneLoad = make_unique<SceneLoad>();
+    sceneLoad->start = EngineClock::now();
+    const auto load = sceneLoad.get();
+    loadTask.launch([this, load] {
+        const auto start = EngineClock::now();
+        if (useScenePack && load->pack.open(SCENE_PACK_FILE, SCENE_FILE)) {
+            // Cooked already, building reads the mapping
+            load->fromPack = true;
+            load->importSeconds = EngineClock::now() - start;
+            return;
+        }
+        load->imported = SceneLoader::importScene(&importer, SCENE_FILE);
+        const auto imported = EngineClock::now();
+        load->importSeconds = imported - start;
+        if (load->imported != nullptr) {
+            SceneLoader::cookMeshes(*load->imported, loadJobs, load->cookedMeshes);
+            load->cookSeconds = EngineClock::now() - imported;
+        }
+    });
+}
+
+void MainWindow::advanceLoading(const bool block)
+{
+    if (!scene) {
+        if (!block && !loadTask.isDone()) {
+            return;
+        }
+        loadTask.wait();
+        initSceneAndShaders();
+        if (!scene) {
+            printf("Could not load %s\n", sceneLoad->fromPack ? SCENE_PACK_FILE : SCENE_FILE);
+            sceneLoad.reset();
+            return;
+        }
+        if (!block) {
+            // Rendering starts with this frame, with whatever is still streaming as placeholders
+            return;
+        }
+    }
+    do {
+        textureStreamer->update();
+    } while (block && !textureStreamer->isIdle());
+    if (!textureStreamer->isIdle()) {
+        return;
+    }
+    // The pack write reads the imported scene and its cooked meshes
+    loadTask.wait();
+    sceneLoad->pack.close();
+
+    // Baked from the final textures
+    const auto bakeStart = EngineClock::now();
+    if (constants::IMPOSTORS) {
+        const auto material = static_pointer_cast<ShaderMaterialDefault>(shaders.at(0))->material;
+        impostors = make_unique<Impostors>();
+        impostors->bake(drawables, material);
+        impostors->setupLighting(illumination, material);
+    }
+    textureCache->trim(constants::TEXTURE_CACHE_BUDGET);
+    const auto end = EngineClock::now();
+    printf("Texture cache: %zu textures (%.1f MB) for %d requests\n", textureCache->getCount(),
+           textureCache->getMemorySize() / (1024.0 * 1024.0), textureCache->getHitCount() + textureCache->getMissCount());
+    printf("Textures: %d streamed, decode %.1f ms on workers, upload %.1f ms over %d frames (%.1f MB), impostors %.1f ms; "
+           "everything loaded after %.1f ms\n", textureStreamer->getTextureCount(), textureStreamer->getDecodeSeconds() * 1000.0,
+           textureStreamer->getUploadSeconds() * 1000.0, textureStreamer->getUploadFrames(),
+           textureStreamer->getUploadedBytes() / (1024.0 * 1024.0), (end - bakeStart) * 1000.0, (end - sceneLoad->start) * 1000.0);
+    sceneLoad.reset();
+}
+
+void MainWindow::finishLoading()
+{
+    if (sceneLoad) {
+        advanceLoading(true);
+    }
+}
+
+// The GL thread part of loading, once the file is read and cooked
 void MainWindow::initSceneAndShaders()
 {
+    const auto buildStart = EngineClock::now();
     SceneLoader sceneLoader;
-    scene = sceneLoader.loadScene(&importer, "DemoScene.fbx", illumination, shaders, cameras, waterObjects);
+    sceneLoader.setTextureCache(textureCache.get());
+    if (sceneLoad->fromPack) {
+        scene = sceneLoader.loadScenePack(sceneLoad->pack, illumination, shaders, cameras, waterObjects);
+    } else if (sceneLoad->imported != nullptr) {
+        scene = sceneLoader.loadScene(sceneLoad->imported, sceneLoad->cookedMeshes, illumination, shaders, cameras, waterObjects);
+    }
+    if (!scene) {
+        return;
+    }
+    if (forceWaterModes) {
+        for (const auto& waterObject : waterObjects) {
+            waterObject->modes = forcedWaterModes;
+        }
+    }
     scene->setIllumination(illumination);
     shared_ptr<Camera> mainCamera = nullptr;
     for (const auto& camera : cameras) {
@@ -27,8 +152,43 @@ void MainWindow::initSceneAndShaders()
         mainCamera = cameras.at(0);
     }
     scene->setCurrentCamera(mainCamera);
+    scene->setCommandBuffer(make_shared<SceneCommandBuffer>());
+    scene->setEngineClock(make_shared<EngineClock>(simulationRate));
+    skyBox = static_pointer_cast<SkyBox>(scene->getComponentFirst(SkyBoxComponent));
+    hlod = static_pointer_cast<Hlod>(scene->getComponentFirst(HlodComponent));
+    collectDrawables();
+    collectAnimations();
     depthShader = std::make_shared<ShaderFastMeshRender>(scene);
     scene->addComponent(depthShader);
+
+    scene->callObjectMounted();
+    sceneUpdater.build(scene);
+    auto& snapshot = snapshots[renderSnapshot];
+    captureState(snapshot.current);
+    snapshot.previous = snapshot.current;
+
+    const auto end = EngineClock::now();
+    printf("Scene loaded from %s: %s %.1f ms, cook %.1f ms (%u meshes), build %.1f ms, first frame after %.1f ms\n",
+           sceneLoad->fromPack ? SCENE_PACK_FILE : SCENE_FILE, sceneLoad->fromPack ? "open" : "import",
+           sceneLoad->importSeconds * 1000.0, sceneLoad->cookSeconds * 1000.0,
+           sceneLoad->imported != nullptr ? sceneLoad->imported->mNumMeshes : 0u, (end - buildStart) * 1000.0,
+           (end - sceneLoad->start) * 1000.0);
+
+    if (sceneLoad->fromPack || !useScenePack) {
+        return;
+    }
+    // The pack is missing or older than the scene. The next run starts from a fresh one, written from the meshes
+    // cooked for this one on loadTask while the textures stream in.
+    const auto load = sceneLoad.get();
+    loadTask.launch([load] {
+        const auto start = EngineClock::now();
+        if (ScenePack::cook(*load->imported, load->cookedMeshes, SCENE_FILE, SCENE_PACK_FILE)) {
+            printf("Wrote %s in %.1f ms\n", SCENE_PACK_FILE, (EngineClock::now() - start) * 1000.0);
+        } else {
+            printf("Could not write %s\n", SCENE_PACK_FILE);
+        }
+        load->cookedMeshes.clear();
+    });
 }
 
 MainWindow::MainWindow() = default;
@@ -75,7 +235,10 @@ bool MainWindow::show()
         printf("Error initializing GLEW! %p\n", glewGetErrorString(glewError));
     }
 
-    initSceneAndShaders();
+    // Layered rendering with gl_Layer from the geometry shader is core since 3.2
+    multiViewSupported = GLEW_VERSION_3_2;
+
+    screenCapture = make_unique<ScreenCapture>(constants::SCREEN_WIDTH, constants::SCREEN_HEIGHT);
     glEnable(GL_ALPHA_TEST);
     glEnable(GL_BLEND);
     glEnable(GL_DEPTH_TEST);
@@ -89,108 +252,669 @@ bool MainWindow::show()
         return false;
     }
 
-    scene->callObjectMounted();
+    textureStreamer = make_unique<TextureStreamer>(loadJobs);
+    textureCache = make_unique<TextureCache>(textureStreamer.get());
+    startLoading();
+    return true;
+}
+
+void MainWindow::setUseScenePack(const bool useScenePack)
+{
+    this->useScenePack = useScenePack;
+}
 
+bool MainWindow::cookScene()
+{
+    Assimp::Importer cookImporter;
+    const auto start = EngineClock::now();
+    const auto source = SceneLoader::importScene(&cookImporter, SCENE_FILE);
+    if (source == nullptr) {
+        return false;
+    }
+    const auto imported = EngineClock::now();
+    JobSystem cookJobs;
+    std::vector<Mesh::CookedGeometry> cookedMeshes;
+    SceneLoader::cookMeshes(*source, cookJobs, cookedMeshes);
+    if (!ScenePack::cook(*source, cookedMeshes, SCENE_FILE, SCENE_PACK_FILE)) {
+        printf("Could not write %s\n", SCENE_PACK_FILE);
+        return false;
+    }
+    printf("Cooked %s into %s: import %.1f ms, cook %.1f ms\n", SCENE_FILE, SCENE_PACK_FILE, (imported - start) * 1000.0,
+           (EngineClock::now() - imported) * 1000.0);
     return true;
 }
 
-void MainWindow::propagateUpdate() const
+void MainWindow::setWaterModes(const WaterModes& modes)
+{
+    forceWaterModes = true;
+    forcedWaterModes = modes;
+}
+
+void MainWindow::setPipelined(const bool pipelined)
+{
+    this->pipelined = pipelined;
+}
+
+void MainWindow::setParallelUpdate(const bool parallelUpdate)
+{
+    this->parallelUpdate = parallelUpdate;
+}
+
+void MainWindow::setSimulationRate(const double stepRate)
+{
+    simulationRate = stepRate;
+    if (scene) {
+        scene->engineClock->setStepRate(stepRate);
+    }
+}
+
+void MainWindow::setAnimationStats(const bool animationStats)
+{
+    this->animationStats = animationStats;
+}
+
+void MainWindow::propagateFrame()
+{
+    if (sceneLoad) {
+        advanceLoading(false);
+    }
+    if (!scene) {
+        // Still reading the file
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        SDL_GL_SwapWindow(sdlWindow);
+        return;
+    }
+    publishVisibility();
+    // However many fixed steps the real time since the last frame pays for, rendering interpolates the rest
+    const auto steps = scene->engineClock->advance();
+    const auto interpolation = scene->engineClock->getInterpolation();
+    if (!pipelined) {
+        auto& snapshot = snapshots[renderSnapshot];
+        propagateUpdate(snapshot, steps);
+        syncScene(snapshot);
+        snapshot.interpolation = interpolation;
+        propagateRender();
+        reportAnimationStats();
+        return;
+    }
+    // Frame N draws from its snapshot while frame N+1 is simulated into the other one, so a frame costs about
+    // max(update, render). Input was delivered before this call, while no update was running.
+    const auto nextSnapshot = 1 - renderSnapshot;
+    auto& next = snapshots[nextSnapshot];
+    next.previous = snapshots[renderSnapshot].previous;
+    next.current = snapshots[renderSnapshot].current;
+    next.interpolation = interpolation;
+    updateTask.launch([this, &next, steps] {
+        propagateUpdate(next, steps);
+    });
+    propagateRender();
+    updateTask.wait();
+    syncScene(next);
+    renderSnapshot = nextSnapshot;
+    reportAnimationStats();
+}
+
+void MainWindow::propagateUpdate(SceneSnapshot& snapshot, const int steps)
+{
+    updateEvaluatedChannels = 0;
+    for (auto i = 0; i < steps; ++i) {
+        std::swap(snapshot.previous, snapshot.current);
+        scene->engineClock->step();
+        updateScene();
+        for (const auto& animation : animations) {
+            updateEvaluatedChannels += animation->getEvaluatedChannels();
+        }
+        captureState(snapshot.current);
+    }
+}
+
+// The sync point: neither thread walks the scene, so structural changes recorded by the update land here
+void MainWindow::syncScene(SceneSnapshot& snapshot)
+{
+    if (applySceneCommands()) {
+        // Indices into the states changed with the hierarchy, there is nothing to interpolate from
+        captureState(snapshot.current);
+        snapshot.previous = snapshot.current;
+    }
+}
+
+bool MainWindow::applySceneCommands()
+{
+    if (!scene->commandBuffer->apply(scene)) {
+        return false;
+    }
+    collectDrawables();
+    collectAnimations();
+    // The last camera pass measured the old drawables
+    drawableScreenSizes.clear();
+    // Removed objects may have held the last reference to their textures
+    textureCache->trim(constants::TEXTURE_CACHE_BUDGET);
+    sceneUpdater.build(scene);
+    return true;
+}
+
+void MainWindow::collectDrawables()
+{
+    drawables.clear();
+    skinnedDrawables.clear();
+    for (const auto& object : scene->getGlobalChildrenList()) {
+        for (const auto& mesh : object->getComponentList(MeshComponent)) {
+            drawables.push_back(static_pointer_cast<Mesh>(mesh));
+            if (drawables.back()->isSkinned()) {
+                skinnedDrawables.push_back(drawables.size() - 1);
+            }
+        }
+    }
+    if (hlod) {
+        hlod->bindDrawables(drawables);
+    }
+    if (impostors) {
+        impostors->bindDrawables(drawables);
+    }
+}
+
+void MainWindow::collectAnimations()
+{
+    animations.clear();
+    auto objects = scene->getGlobalChildrenList();
+    objects.push_front(scene);
+    for (const auto& object : objects) {
+        for (const auto& animation : object->getComponentList(ObjectAnimationComponent)) {
+            animations.push_back(static_pointer_cast<ObjectAnimation>(animation));
+        }
+    }
+}
+
+// Between frames, so neither the update nor the render is touching the meshes. Animations read the sizes as
+// their level of detail, one frame behind the culling that produced them.
+void MainWindow::publishVisibility()
 {
-    scene->callUpdate();
+    if (drawableScreenSizes.size() != drawables.size()) {
+        return;
+    }
+    for (auto i = 0u; i < drawables.size(); ++i) {
+        drawables[i]->screenSize = drawableScreenSizes[i];
+    }
+}
+
+void MainWindow::recordVisibility(const DrawList& cameraDrawList)
+{
+    drawableScreenSizes.assign(drawables.size(), 0.0f);
+    const auto& view = cameraDrawList.getView();
+    for (const auto& command : cameraDrawList.getCommands()) {
+        drawableScreenSizes[command.drawable] = view.getScreenSize(*command.mesh, command.model);
+    }
+    const auto& meshModels = snapshots[renderSnapshot].meshModels;
+    for (const auto drawable : cameraDrawList.getImpostors()) {
+        drawableScreenSizes[drawable] = view.getScreenSize(*drawables[drawable], meshModels[drawable]);
+    }
+}
+
+void MainWindow::reportAnimationStats()
+{
+    if (!animationStats) {
+        return;
+    }
+    statsEvaluatedChannels += updateEvaluatedChannels;
+    ++statsFrames;
+    const auto now = EngineClock::now();
+    if (now - statsStart < 1.0) {
+        return;
+    }
+    size_t boundChannels = 0;
+    for (const auto& animation : animations) {
+        boundChannels += animation->getBindingCount();
+    }
+    printf("animation: %.1f of %zu channels evaluated per frame\n", static_cast<double>(statsEvaluatedChannels) / statsFrames, boundChannels);
+    statsEvaluatedChannels = 0;
+    statsFrames = 0;
+    statsStart = now;
+}
+
+void MainWindow::updateScene()
+{
+    if (parallelUpdate) {
+        sceneUpdater.update(jobSystem);
+    } else {
+        scene->callUpdate();
+    }
+}
+
+void MainWindow::benchmarkUpdate() const
+{
+    // Copies of the scene's animated objects under a separate root, enough of them to keep every core busy
+    std::vector<shared_ptr<ObjectAnimation>> sources;
+    for (const auto& animation : animations) {
+        if (animation->clip->getChannelCount() > 0) {
+            sources.push_back(animation);
+        }
+    }
+    if (sources.empty()) {
+        printf("Update benchmark: the scene has no animations\n");
+        return;
+    }
+    const auto root = make_shared<GameObject>("benchmark");
+    root->addComponent(make_shared<Transform>(root));
+    const auto branchSize = constants::UPDATE_JOB_MIN_OBJECTS * 4;
+    shared_ptr<GameObject> branch;
+    shared_ptr<ObjectAnimation> player;
+    for (auto i = 0; i < constants::UPDATE_BENCHMARK_OBJECTS; ++i) {
+        // Each branch plays one of the scene's clips over its objects
+        if (i % branchSize == 0) {
+            branch = make_shared<GameObject>("benchmark branch", root);
+            branch->addComponent(make_shared<Transform>(branch));
+            const auto& source = sources[i / branchSize % sources.size()];
+            player = make_shared<ObjectAnimation>(source->clip, branch);
+            branch->addComponent(player);
+            root->addChild(branch);
+        }
+        const auto object = make_shared<GameObject>("benchmark object", branch);
+        object->addComponent(make_shared<Transform>(object));
+        player->bind(i % player->clip->getChannelCount(), object);
+        branch->addChild(object);
+    }
+    // A clock of its own, so every measured update steps the animations forward like the real loop does
+    const auto clock = make_shared<EngineClock>();
+    root->setEngineClock(clock);
+
+    const auto timeUpdates = [&clock](const std::function<void()>& update) {
+        clock->step();
+        update();
+        const auto start = EngineClock::now();
+        for (auto frame = 0; frame < constants::UPDATE_BENCHMARK_FRAMES; ++frame) {
+            clock->step();
+            update();
+        }
+        return (EngineClock::now() - start) * 1000.0 / constants::UPDATE_BENCHMARK_FRAMES;
+    };
+    printf("Update benchmark: %d animated objects, %d frames\n", constants::UPDATE_BENCHMARK_OBJECTS, constants::UPDATE_BENCHMARK_FRAMES);
+    const auto serial = timeUpdates([&root] { root->callUpdate(); });
+    printf("serial      %8.3f ms\n", serial);
+    SceneUpdater updater;
+    updater.build(root);
+    const auto cores = std::max(1u, std::thread::hardware_concurrency());
+    for (auto threads = 1u; threads <= cores; ++threads) {
+        JobSystem jobs(threads - 1);
+        const auto parallel = timeUpdates([&] { updater.update(jobs); });
+        printf("%2u threads  %8.3f ms  %5.2fx\n", threads, parallel, serial / parallel);
+    }
+}
+
+void MainWindow::benchmarkKeyframes()
+{
+    // One long channel with evenly spaced keys, the aiAnimation owns the channel and the channel its keys
+    const auto keyCount = constants::KEYFRAME_BENCHMARK_KEYS;
+    const auto channel = new aiNodeAnim();
+    channel->mNumPositionKeys = keyCount;
+    channel->mPositionKeys = new aiVectorKey[keyCount];
+    for (auto i = 0u; i < keyCount; ++i) {
+        channel->mPositionKeys[i].mTime = i;
+        channel->mPositionKeys[i].mValue.x = static_cast<float>(i);
+    }
+    const auto duration = keyCount - 1.0;
+    const auto ticksPerSecond = 25.0;
+    const auto animation = make_unique<aiAnimation>();
+    animation->mDuration = duration;
+    animation->mTicksPerSecond = ticksPerSecond;
+    animation->mNumChannels = 1;
+    animation->mChannels = new aiNodeAnim*[1]{ channel };
+    const auto bakeStart = EngineClock::now();
+    const AnimationClip clip(*animation);
+    const auto bakeTime = (EngineClock::now() - bakeStart) * 1000.0;
+
+    // What findPosition did before the cursor and the binary search
+    const auto keys = channel->mPositionKeys;
+    const auto linearScan = [keys, keyCount](const double time) {
+        for (auto i = 0u; i < keyCount - 1; ++i) {
+            if (time > 0 && time < keys[i + 1].mTime) {
+                return i;
+            }
+        }
+        return 0u;
+    };
+
+    std::vector<double> forward(constants::KEYFRAME_BENCHMARK_LOOKUPS);
+    std::vector<double> seeks(constants::KEYFRAME_BENCHMARK_LOOKUPS);
+    std::mt19937 random(42);
+    std::uniform_real_distribution<double> anyTime(0.0, duration);
+    for (auto i = 0u; i < forward.size(); ++i) {
+        forward[i] = duration * i / forward.size();
+        seeks[i] = anyTime(random);
+    }
+    unsigned long long checksum = 0;
+    const auto timeLookups = [&checksum](const std::vector<double>& times, const std::function<unsigned int(double)>& find) {
+        const auto start = EngineClock::now();
+        for (const auto time : times) {
+            checksum += find(time);
+        }
+        return (EngineClock::now() - start) * 1000.0;
+    };
+    auto cursor = 0u;
+    const auto find = [keys, keyCount, &cursor](const double time) { return AnimationClip::findKey(keys, keyCount, time, cursor); };
+    LocalPose pose;
+    const auto sample = [&clip, &pose, ticksPerSecond](const double time) {
+        clip.sample(static_cast<float>(time / ticksPerSecond), pose);
+        return static_cast<unsigned int>(pose.positionX[0]);
+    };
+
+    printf("Keyframe benchmark: %u keys, %d lookups, baked in %.3f ms\n", keyCount, constants::KEYFRAME_BENCHMARK_LOOKUPS, bakeTime);
+    const auto forwardLinear = timeLookups(forward, linearScan);
+    const auto forwardCursor = timeLookups(forward, find);
+    const auto forwardBaked = timeLookups(forward, sample);
+    printf("forward playback  linear %9.3f ms  cursor %9.3f ms  baked %9.3f ms\n", forwardLinear, forwardCursor, forwardBaked);
+    const auto seekLinear = timeLookups(seeks, linearScan);
+    const auto seekBinary = timeLookups(seeks, find);
+    const auto seekBaked = timeLookups(seeks, sample);
+    printf("random seeks      linear %9.3f ms  binary %9.3f ms  baked %9.3f ms\n", seekLinear, seekBinary, seekBaked);
+    printf("checksum %llu\n", checksum);
+}
+
+void MainWindow::captureState(SimulationState& state) const
+{
+    const auto& camera = *scene->currentCamera;
+    state.cameraPosition = camera.getPos();
+    state.cameraFront = camera.getCameraFront();
+    state.cameraUp = camera.getCameraUp();
+    state.cameraProjection = camera.getProjectionMatrix();
+    state.meshTransforms.resize(drawables.size());
+    for (auto i = 0u; i < drawables.size(); ++i) {
+        const auto transform = drawables[i]->getParent()->getTransform();
+        state.meshTransforms[i] = TransformState{ transform->getPosition(), transform->getRotation(), transform->getScale() };
+    }
+    state.skinPalettes.resize(skinnedDrawables.size());
+    for (auto i = 0u; i < skinnedDrawables.size(); ++i) {
+        drawables[skinnedDrawables[i]]->computeSkinPalette(state.skinPalettes[i]);
+    }
+    state.waterModels.clear();
+    for (const auto& waterObject : waterObjects) {
+        state.waterModels.push_back(waterObject->getTransform()->getModelMatrix());
+    }
+    state.waterMoveFactor = static_pointer_cast<ShaderWater>(shaders.at(1))->getMoveFactor();
 }
 
 void MainWindow::propagateRender()
 {
+    // Everything update writes is read from the snapshot, the scene graph may be simulating the next frame
+    auto& snapshot = snapshots[renderSnapshot];
+    snapshot.interpolate();
+    for (auto i = 0u; i < skinnedDrawables.size(); ++i) {
+        drawables[skinnedDrawables[i]]->uploadSkinPalette(snapshot.skinPalettes[i]);
+    }
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    renderGraph.reset();
+    drawLists.clear();
+    drawListPasses.clear();
+    const auto backBuffer = renderGraph.importResource("back buffer", 0, true);
+
+    std::vector<RenderResource> shadowMaps;
     for (const auto& light : illumination) {
         if (light->castShadows) {
-            light->setupShadowMapping(depthShader);
-            scene->callShadowMappingRender(depthShader);
-            light->endShadowMapping();
+            const auto shadowMap = renderGraph.importResource("shadow map");
+            renderGraph.addPass("shadow", {}, { shadowMap }, [this, light, &snapshot](const RenderGraph&) {
+                light->setupShadowMapping(depthShader);
+                if (hlod) {
+                    hlod->selectProxies(snapshot.camera.withLodPass(LodPassShadow), shadowHidden);
+                }
+                for (auto i = 0u; i < drawables.size(); ++i) {
+                    if (i < shadowHidden.size() && shadowHidden[i]) {
+                        continue;
+                    }
+                    const auto& model = snapshot.meshModels[i];
+                    const auto lod = drawables[i]->selectLod(snapshot.camera.getScreenSize(*drawables[i], model), LodPassShadow);
+                    drawables[i]->drawDepth(depthShader, model, lod);
+                }
+                light->endShadowMapping();
+            });
+            shadowMaps.push_back(shadowMap);
 
             break; // TODO: Support more than one shadow light
         }
     }
 
-    glEnable(GL_CLIP_DISTANCE0);
+    const auto& cameraView = snapshot.camera;
+    const auto cameraDrawList = drawLists.size();
+    addScenePass("scene", cameraView, shadowMaps, backBuffer, true);
+
+    // Copies of the scene pass, only kept when a water body below reads them
+    const auto sceneCapture = renderGraph.importResource("scene capture");
+    renderGraph.addPass("scene capture", { backBuffer }, { sceneCapture }, [this](const RenderGraph&) {
+        screenCapture->capture();
+    });
+    const auto depthPyramid = renderGraph.importResource("depth pyramid");
+    renderGraph.addPass("depth pyramid", { sceneCapture }, { depthPyramid }, [this](const RenderGraph&) {
+        screenCapture->buildDepthPyramid();
+    });
+
+    auto water = 0u;
     for (const auto& waterObject : waterObjects) {
-        auto clippingPlane = glm::vec4(0.0, -1.0, 0.0, waterObject->getTransform()->getPosition().y);
-        auto shader = static_pointer_cast<ShaderMaterialDefault>(shaders.at(0));
-        shader->use();
-        shader->setClippingPlane(clippingPlane);
-
-        waterObject->setupRefraction();
-        scene->callRender();
-        waterObject->endRefraction();
-
-        //Camera Mirror
-        auto cam = scene->currentCamera;
+        const auto& waterModel = snapshot.waterModels[water++];
+        if (waterObject->isVisible(cameraView, waterModel)) {
+            addWaterPasses(cameraView, waterObject, waterModel, snapshot.waterMoveFactor, shadowMaps, backBuffer, sceneCapture, depthPyramid);
+        }
+    }
 
-        auto cameraTransform = cam->getParent()->getTransform();
-        auto auxPosition = cameraTransform->getPosition();
-        auto auxFront = cam->getCameraFront();
-        auto auxRight = cam->getCameraRight();
-        auto auxUp = cam->getCameraUp();
+    renderGraph.compile();
+    recordDrawLists();
+    recordVisibility(*drawLists[cameraDrawList]);
+    renderGraph.execute();
 
-        cameraTransform->setPositionY(auxPosition.y - 2 * (auxPosition.y - waterObject->getTransform()->getPosition().y));
-        auto newCameraFront = normalize(glm::vec3(auxFront.x, auxFront.y * -1.0, auxFront.z));
-        auto newCameraRight = normalize(cross(newCameraFront, glm::vec3(0.0f, 1.0f, 0.0f)));
-        auto newCameraUp = normalize(cross(newCameraRight, newCameraFront));
+    SDL_GL_SwapWindow(sdlWindow);
+}
 
-        cam->setCameraFront(newCameraFront.x, newCameraFront.y, newCameraFront.z);
-        cam->setCameraRight(newCameraRight.x, newCameraRight.y, newCameraRight.z);
-        cam->setCameraUp(newCameraUp.x, newCameraUp.y, newCameraUp.z);
+void MainWindow::addWaterPasses(const RenderView& cameraView, const shared_ptr<Water>& waterObject, const glm::mat4& waterModel,
+                                const float waterMoveFactor, const std::vector<RenderResource>& shadowMaps,
+                                const RenderResource backBuffer, const RenderResource sceneCapture,
+                                const RenderResource depthPyramid)
+{
+    const auto waterHeight = waterModel[3].y;
+    const auto reflectionPlane = glm::vec4(0.0, 1.0, 0.0, -waterHeight);
+    const auto refractionPlane = glm::vec4(0.0, -1.0, 0.0, waterHeight);
+    const auto screenSpaceRefraction = waterObject->modes.refractionMode == ScreenSpaceRefraction;
+    const auto screenSpaceReflection = waterObject->modes.reflectionMode == ScreenSpaceReflection;
+    const auto multiView = multiViewSupported && waterObject->modes.multiView && !waterObject->modes.obliqueClipping
+        && !screenSpaceRefraction && !screenSpaceReflection;
+    const RenderTargetDesc targetDesc{ constants::SCREEN_WIDTH, constants::SCREEN_HEIGHT, 1 };
+
+    // Each water pass reads only the sources its modes need, the graph drops the passes producing the rest
+    std::vector<RenderResource> reads;
+    auto reflection = -1;
+    auto refraction = -1;
+    auto layered = -1;
+    if (multiView) {
+        // One traversal for both views: the geometry shader emits each triangle to the reflection and refraction layers
+        layered = renderGraph.createTarget("water multi view", RenderTargetDesc{ targetDesc.width, targetDesc.height, constants::MULTI_VIEW_COUNT });
+        // Proxies switch once for both layers, on the reflection pass's state
+        const auto layeredView = cameraView
+            .withLayers(cameraView.mirrored(waterHeight).withClippingPlane(reflectionPlane, false).withLodPass(LodPassReflection),
+                        cameraView.withClippingPlane(refractionPlane, false).withLodPass(LodPassRefraction))
+            .withLodPass(LodPassReflection);
+        addScenePass("water multi view", layeredView, shadowMaps, layered, true);
+        reads.push_back(layered);
+    } else {
+        if (screenSpaceRefraction) {
+            reads.push_back(sceneCapture);
+        } else {
+            refraction = renderGraph.createTarget("water refraction", targetDesc);
+            const auto refractionView = cameraView.withClippingPlane(refractionPlane, waterObject->modes.obliqueClipping)
+                .withLodPass(LodPassRefraction);
+            addScenePass("water refraction", refractionView, shadowMaps, refraction, false);
+            reads.push_back(refraction);
+        }
+        if (screenSpaceReflection) {
+            reads.push_back(sceneCapture);
+            reads.push_back(depthPyramid);
+        } else {
+            reflection = renderGraph.createTarget("water reflection", targetDesc);
+            const auto reflectionView = cameraView.mirrored(waterHeight)
+                .withClippingPlane(reflectionPlane, waterObject->modes.obliqueClipping)
+                .withLodPass(LodPassReflection);
+            addScenePass("water reflection", reflectionView, shadowMaps, reflection, true);
+            reads.push_back(reflection);
+        }
+    }
 
+    renderGraph.addPass("water", reads, { backBuffer },
+                        [this, waterObject, cameraView, waterModel, waterMoveFactor, reflection, refraction, layered,
+                         screenSpaceRefraction, screenSpaceReflection](const RenderGraph& graph) {
+        auto shader = static_pointer_cast<ShaderWater>(shaders.at(1));
         shader->use();
-        clippingPlane = glm::vec4(0.0, 1.0, 0.0, -waterObject->getTransform()->getPosition().y);
-        shader->setClippingPlane(clippingPlane);
+        shader->addMoveFactor(waterMoveFactor);
+        if (reflection >= 0) {
+            shader->addReflectionTexture(graph.bindTexture(reflection, constants::REFLECTION_MAP_GL_PLACE));
+        }
+        if (refraction >= 0) {
+            shader->addRefractionTexture(graph.bindTexture(refraction, constants::REFRACTION_MAP_GL_PLACE));
+        }
+        shader->addMultiViewTexture(layered >= 0 ? graph.bindTexture(layered, constants::MULTI_VIEW_MAP_GL_PLACE) : -1);
+        if (screenSpaceRefraction) {
+            shader->addSceneTextures(screenCapture->bindColorTexture(constants::SCENE_COLOR_MAP_GL_PLACE),
+                                     screenCapture->bindDepthTexture(constants::SCENE_DEPTH_MAP_GL_PLACE));
+        } else {
+            shader->addSceneTextures(-1, -1);
+        }
+        if (screenSpaceReflection) {
+            // Hits are shaded from the captured color, already on its unit for the refraction case
+            screenCapture->bindColorTexture(constants::SCENE_COLOR_MAP_GL_PLACE);
+            shader->addScreenSpaceReflection(screenCapture->bindDepthPyramid(constants::DEPTH_PYRAMID_GL_PLACE),
+                                             screenCapture->getDepthPyramidLevels(),
+                                             skyBox != nullptr ? skyBox->bindTexture(constants::SKYBOX_MAP_GL_PLACE) : -1);
+        } else {
+            shader->addScreenSpaceReflection(-1, 0, -1);
+        }
+        waterObject->renderWater(cameraView, waterModel);
+    });
+}
 
-        waterObject->setupReflection();
-        scene->callRender();
-        scene->callLateRender();
-        waterObject->endReflection();
+void MainWindow::addScenePass(const std::string& name, const RenderView& view, const std::vector<RenderResource>& reads,
+                              const RenderResource target, const bool lateRender)
+{
+    const auto drawList = drawLists.size();
+    drawLists.push_back(make_unique<DrawList>(view));
+    const auto pass = renderGraph.addPass(name, reads, { target }, [this, drawList, target, lateRender](const RenderGraph& graph) {
+        renderDrawList(*drawLists[drawList], graph.getFrameBuffer(target), lateRender);
+    });
+    drawListPasses.push_back(pass);
+}
 
-        // Camera Reset
-        cameraTransform->setPosition(auxPosition);
-        cam->setCameraFront(auxFront.x, auxFront.y, auxFront.z);
-        cam->setCameraRight(auxRight.x, auxRight.y, auxRight.z);
-        cam->setCameraUp(auxUp.x, auxUp.y, auxUp.z);
+void MainWindow::recordDrawLists()
+{
+    // Only the lists of passes that survived culling, every (list, chunk) pair is one job
+    std::vector<DrawList*> recorded;
+    for (auto i = 0u; i < drawLists.size(); ++i) {
+        if (renderGraph.isScheduled(drawListPasses[i])) {
+            recorded.push_back(drawLists[i].get());
+        }
     }
-    glDisable(GL_CLIP_DISTANCE0);
+    const auto& meshModels = snapshots[renderSnapshot].meshModels;
+    const auto chunkSize = static_cast<size_t>(constants::DRAW_LIST_CHUNK_SIZE);
+    const auto chunkCount = static_cast<int>((drawables.size() + chunkSize - 1) / chunkSize);
+    // Proxies and impostors are chosen up front, they keep switching state per pass
+    drawListHidden.resize(recorded.size());
+    for (auto i = 0u; i < recorded.size(); ++i) {
+        recorded[i]->beginRecording(chunkCount);
+        drawListHidden[i].clear();
+        if (hlod) {
+            hlod->selectProxies(recorded[i]->getView(), drawListHidden[i]);
+        }
+        if (impostors) {
+            impostors->select(recorded[i]->getView(), drawables, meshModels, drawListHidden[i], recorded[i]->getImpostors());
+        }
+    }
+    jobSystem.parallelFor(static_cast<int>(recorded.size()) * chunkCount, [&](const int job) {
+        const auto chunk = job % chunkCount;
+        const auto begin = chunk * chunkSize;
+        const auto list = job / chunkCount;
+        recorded[list]->recordChunk(chunk, drawables, meshModels, drawListHidden[list], begin,
+                                    std::min(begin + chunkSize, drawables.size()));
+    });
+    jobSystem.parallelFor(static_cast<int>(recorded.size()), [&](const int list) {
+        recorded[list]->endRecording();
+    });
+}
 
+void MainWindow::renderDrawList(const DrawList& drawList, const unsigned int target, const bool lateRender) const
+{
+    const auto view = drawList.getView().withTarget(target);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if (view.usesClipDistance()) {
+        glEnable(GL_CLIP_DISTANCE0);
+    } else {
+        glDisable(GL_CLIP_DISTANCE0);
+    }
 
-    scene->callRender();
-    scene->callLateRender();
-
-    auto shader = static_pointer_cast<ShaderWater>(shaders.at(1));
-    for (const auto& waterObject : waterObjects) {
-        shader->use();
-        shader->addReflectionTexture(waterObject->bindReflectionTexture());
-        shader->addRefractionTexture(waterObject->bindRefractionTexture());
-        waterObject->renderWater();
+    drawList.submit(view, false);
+    if (impostors) {
+        impostors->draw(view, drawList.getImpostors(), snapshots[renderSnapshot].meshModels);
+    }
+    scene->callRender(view);
+    if (lateRender) {
+        // Like the planar refraction pass, the refraction layer of a layered pass leaves the late meshes out
+        const auto lateView = view.isMultiView() ? view.withoutLayer(constants::MULTI_VIEW_REFRACTION_LAYER) : view;
+        scene->callLateRender(lateView);
+        drawList.submit(lateView, true);
     }
 
-    SDL_GL_SwapWindow(sdlWindow);
+    glDisable(GL_CLIP_DISTANCE0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void MainWindow::propagateKeyPressed(const KeyCode key) const
 {
-    scene->callKeyboardKeyDown(key);
+    if (scene && !toggleWaterModes(key)) {
+        scene->callKeyboardKeyDown(key);
+    }
+}
+
+bool MainWindow::toggleWaterModes(const KeyCode key) const
+{
+    if (key != SDLK_F1 && key != SDLK_F2 && key != SDLK_F3 && key != SDLK_F4) {
+        return false;
+    }
+    // Every water body switches together from the next frame on, so the modes can be compared on the same view
+    for (const auto& waterObject : waterObjects) {
+        auto& modes = waterObject->modes;
+        switch (key) {
+        case SDLK_F1:
+            modes.obliqueClipping = !modes.obliqueClipping;
+            break;
+        case SDLK_F2:
+            modes.refractionMode = modes.refractionMode == PlanarRefraction ? ScreenSpaceRefraction : PlanarRefraction;
+            break;
+        case SDLK_F3:
+            modes.reflectionMode = modes.reflectionMode == PlanarReflection ? ScreenSpaceReflection : PlanarReflection;
+            break;
+        case SDLK_F4:
+            modes.multiView = !modes.multiView;
+            break;
+        default: ;
+        }
+        printf("%s: oblique clipping %s, multi view %s, %s refraction, %s reflection\n", waterObject->getName().c_str(),
+               modes.obliqueClipping ? "on" : "off", modes.multiView ? "on" : "off",
+               modes.refractionMode == ScreenSpaceRefraction ? "screen space" : "planar",
+               modes.reflectionMode == ScreenSpaceReflection ? "screen space" : "planar");
+    }
+    return true;
 }
 
 void MainWindow::propagateKeyUp(const KeyCode key) const
 {
-    scene->callKeyboardKeyUp(key);
+    if (scene) {
+        scene->callKeyboardKeyUp(key);
+    }
 }
 
 void MainWindow::propagateMouse(const MouseButtonCode button, const int x, const int y) const
 {
-    scene->callMouseButton(button, x, y);
+    if (scene) {
+        scene->callMouseButton(button, x, y);
+    }
 }
 
 void MainWindow::propagateMouseMoved(const int x, const int y) const
 {
-    scene->callMouseMotionEvent(x, y);
+    if (scene) {
+        scene->callMouseMotionEvent(x, y);
+    }
 }
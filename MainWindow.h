@@ -1,35 +1,124 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <SDL.h>
 #include "GameObject.h"
+#include "RenderGraph.h"
+#include "JobSystem.h"
+#include "FrameTask.h"
+#include "SceneSnapshot.h"
+#include "SceneUpdater.h"
+#include "WaterModes.h"
 #include <assimp/Importer.hpp>
+#include <glm/glm.hpp>
 
 class Shader;
 class ShaderFastMeshRender;
 class Water;
+class ScreenCapture;
+class SkyBox;
+class RenderView;
+class DrawList;
+class Mesh;
+class ObjectAnimation;
+class Hlod;
+class Impostors;
+class TextureStreamer;
+class TextureCache;
 
 class MainWindow {
 public:
     MainWindow();
     ~MainWindow();
     void initSceneAndShaders();
+    // Opens the window and starts loading the scene, frames show what has loaded so far
     bool show();
+    // Blocks until the load show() started is done, textures included
+    void finishLoading();
 
-    void propagateUpdate() const;
+    void propagateFrame();
     void propagateRender();
+    void setPipelined(bool pipelined);
+    void setParallelUpdate(bool parallelUpdate);
+    void setSimulationRate(double stepRate);
+    void setAnimationStats(bool animationStats);
+    void setUseScenePack(bool useScenePack);
+    // Every water body renders with these, whatever the scene asks for
+    void setWaterModes(const WaterModes& modes);
+    static bool cookScene(); // DemoScene.fbx to DemoScene.pack, needs no window
+    void benchmarkUpdate() const;
+    static void benchmarkKeyframes();
     void propagateKeyPressed(KeyCode key) const;
     void propagateKeyUp(KeyCode key) const;
     void propagateMouse(MouseButtonCode button, int x, int y) const;
     void propagateMouseMoved(int x, int y) const;
 
 private:
+    struct SceneLoad;
+
+    void startLoading();
+    void advanceLoading(bool block);
+    void propagateUpdate(SceneSnapshot& snapshot, int steps);
+    void syncScene(SceneSnapshot& snapshot);
+    void updateScene();
+    bool applySceneCommands();
+    void collectDrawables();
+    void collectAnimations();
+    void publishVisibility();
+    void recordVisibility(const DrawList& cameraDrawList);
+    void reportAnimationStats();
+    void captureState(SimulationState& state) const;
+    bool toggleWaterModes(KeyCode key) const; // false for keys that don't toggle one
+    void addWaterPasses(const RenderView& cameraView, const shared_ptr<Water>& waterObject, const glm::mat4& waterModel,
+                        float waterMoveFactor, const std::vector<RenderResource>& shadowMaps, RenderResource backBuffer,
+                        RenderResource sceneCapture, RenderResource depthPyramid);
+    void addScenePass(const std::string& name, const RenderView& view, const std::vector<RenderResource>& reads,
+                      RenderResource target, bool lateRender);
+    void recordDrawLists();
+    void renderDrawList(const DrawList& drawList, unsigned int target, bool lateRender) const;
+
     shared_ptr<GameObject> scene;
-    SDL_Window* sdlWindow;
-    SDL_GLContext sdlContext;
+    SDL_Window* sdlWindow = nullptr;
+    SDL_GLContext sdlContext = nullptr;
     std::list<shared_ptr<Light>> illumination;
     std::vector<shared_ptr<Shader>> shaders;
     std::vector<shared_ptr<Camera>> cameras;
     std::list<shared_ptr<Water>> waterObjects;
     shared_ptr<ShaderFastMeshRender> depthShader;
     Assimp::Importer importer;
+    bool multiViewSupported = false;
+    unique_ptr<ScreenCapture> screenCapture;
+    unique_ptr<Impostors> impostors;
+    shared_ptr<SkyBox> skyBox;
+    shared_ptr<Hlod> hlod;
+    RenderGraph renderGraph;
+    JobSystem jobSystem;
+    JobSystem loadJobs; // cooking and decoding, apart so a frame never picks up a job that long
+    unique_ptr<SceneLoad> sceneLoad; // while loading
+    unique_ptr<TextureStreamer> textureStreamer; // after sceneLoad, its decodes may read from the pack
+    unique_ptr<TextureCache> textureCache;
+    std::vector<shared_ptr<Mesh>> drawables;
+    std::vector<size_t> skinnedDrawables; // indices into drawables
+    std::vector<float> drawableScreenSizes; // from the last camera pass, handed to the meshes between frames
+    std::vector<shared_ptr<ObjectAnimation>> animations;
+    std::vector<unique_ptr<DrawList>> drawLists;
+    std::vector<int> drawListPasses;
+    std::vector<std::vector<std::uint8_t>> drawListHidden; // per recorded list, the drawables HLOD proxies replace
+    std::vector<std::uint8_t> shadowHidden;
+    SceneSnapshot snapshots[2];
+    int renderSnapshot = 0;
+    bool pipelined = false;
+    bool parallelUpdate = false;
+    double simulationRate = constants::SIMULATION_STEP_RATE;
+    bool animationStats = false;
+    bool useScenePack = true; // loads DemoScene.pack instead of importing DemoScene.fbx when a valid one is there
+    bool forceWaterModes = false;
+    WaterModes forcedWaterModes;
+    unsigned int updateEvaluatedChannels = 0; // by the steps of the last propagateUpdate
+    unsigned long long statsEvaluatedChannels = 0;
+    int statsFrames = 0;
+    double statsStart = 0.0;
+    SceneUpdater sceneUpdater;
+    FrameTask loadTask; // import and mesh cooking, then writing the pack
+    FrameTask updateTask; // last, so a running update is joined before anything it touches is destroyed
 };
@@ -0,0 +1,98 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+#ifdef _WIN32
+    const auto handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    file = handle;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0) {
+        close();
+        return false;
+    }
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        close();
+        return false;
+    }
+    view = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (view == nullptr) {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const auto descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+        ::close(descriptor);
+        return false;
+    }
+    const auto address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // The mapping keeps its own reference to the file
+    ::close(descriptor);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    view = static_cast<const unsigned char*>(address);
+    length = static_cast<size_t>(status.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (view != nullptr) {
+        UnmapViewOfFile(view);
+    }
+    if (mapping != nullptr) {
+        CloseHandle(mapping);
+    }
+    if (file != nullptr) {
+        CloseHandle(file);
+    }
+    mapping = nullptr;
+    file = nullptr;
+#else
+    if (view != nullptr) {
+        munmap(const_cast<unsigned char*>(view), length);
+    }
+#endif
+    view = nullptr;
+    length = 0;
+}
+
+const unsigned char* MappedFile::data() const
+{
+    return view;
+}
+
+size_t MappedFile::size() const
+{
+    return length;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read only view of a whole file through the OS page cache. Nothing is copied on open, pages are faulted in as
+// they are touched, so a large file costs only what is actually read.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    const unsigned char* data() const;
+    size_t size() const;
+
+private:
+    const unsigned char* view = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
@@ -12,7 +12,7 @@ public:
     ~Material();
     ComponentKey getComponentKey() override;
     glm::vec4 diffuse;
-    unique_ptr<Texture> diffuseMap;
+    shared_ptr<Texture> diffuseMap;
     glm::vec4 specular;
     unique_ptr<Texture> specularMap;
     glm::vec4 ambient;
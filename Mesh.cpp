@@ -5,16 +5,153 @@
 #include "ShaderFastMeshRender.h"
 #include "ShaderWater.h"
 #include "Material.h"
-#include "Camera.h"
+#include "RenderView.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshClusterBuilder.h"
 #include <vector>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+namespace {
+    // Assimp matrices are row major
+    glm::mat4 toGlm(const aiMatrix4x4& m)
+    {
+        return glm::mat4(glm::vec4(m.a1, m.b1, m.c1, m.d1), glm::vec4(m.a2, m.b2, m.c2, m.d2),
+                         glm::vec4(m.a3, m.b3, m.c3, m.d3), glm::vec4(m.a4, m.b4, m.c4, m.d4));
+    }
+
+    std::uint16_t toUnorm16(const float value)
+    {
+        return static_cast<std::uint16_t>(std::lround(std::max(0.0f, std::min(1.0f, value)) * 65535.0f));
+    }
+
+    std::int16_t toSnorm16(const float value)
+    {
+        return static_cast<std::int16_t>(std::lround(std::max(-1.0f, std::min(1.0f, value)) * 32767.0f));
+    }
+
+    // Rounded to nearest. Values too small for a normal half become 0, texture coordinates don't miss them.
+    std::uint16_t toHalf(const float value)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        const auto sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000u);
+        const auto exponent = static_cast<int>((bits >> 23) & 0xffu) - 127 + 15;
+        const auto mantissa = bits & 0x7fffffu;
+        if (exponent <= 0) {
+            return sign;
+        }
+        if (exponent >= 31) {
+            return static_cast<std::uint16_t>(sign | 0x7c00u);
+        }
+        // A carry out of the mantissa correctly bumps the exponent
+        auto half = static_cast<std::uint32_t>(sign) | static_cast<std::uint32_t>(exponent) << 10 | mantissa >> 13;
+        if (mantissa & 0x1000u) {
+            ++half;
+        }
+        return static_cast<std::uint16_t>(half);
+    }
+
+    // Projects the unit normal onto the octahedron and folds the lower half over the upper one
+    void toOctahedral(const glm::vec3& normal, std::int16_t encoded[2])
+    {
+        const auto length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+        auto x = length > 0.0f ? normal.x / length : 0.0f;
+        auto y = length > 0.0f ? normal.y / length : 0.0f;
+        if (length > 0.0f && normal.z < 0.0f) {
+            const auto foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const auto foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+        encoded[0] = toSnorm16(x);
+        encoded[1] = toSnorm16(y);
+    }
+
+    float fromHalf(const std::uint16_t half)
+    {
+        const auto sign = (half & 0x8000u) != 0 ? -1.0f : 1.0f;
+        const auto exponent = static_cast<int>((half >> 10) & 0x1fu);
+        const auto mantissa = static_cast<float>(half & 0x3ffu);
+        if (exponent == 0) {
+            return sign * std::ldexp(mantissa, -24);
+        }
+        if (exponent == 31) {
+            return sign * std::numeric_limits<float>::infinity();
+        }
+        return sign * std::ldexp(1024.0f + mantissa, exponent - 25);
+    }
+
+    glm::vec3 fromOctahedral(const std::int16_t encoded[2])
+    {
+        auto x = std::max(-1.0f, encoded[0] / 32767.0f);
+        auto y = std::max(-1.0f, encoded[1] / 32767.0f);
+        const auto z = 1.0f - std::fabs(x) - std::fabs(y);
+        if (z < 0.0f) {
+            const auto unfoldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            const auto unfoldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = unfoldedX;
+            y = unfoldedY;
+        }
+        return glm::normalize(glm::vec3(x, y, z));
+    }
+
+    // Whether every edge is shared by exactly two triangles winding it opposite ways. UV and normal seams split
+    // vertices, so they are welded by position first.
+    bool isClosed(const vector<Mesh::Vertex>& vertices, const unsigned int* indices, const unsigned int indexCount)
+    {
+        if (indexCount == 0) {
+            return false;
+        }
+        std::map<std::array<float, 3>, unsigned int> positions;
+        vector<unsigned int> welded(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const auto& position = vertices[i].position;
+            const std::array<float, 3> key = { { position.x, position.y, position.z } };
+            welded[i] = positions.emplace(key, static_cast<unsigned int>(positions.size())).first->second;
+        }
+        // Directed edge, from in the high half, to the number of triangles having it
+        std::unordered_map<std::uint64_t, unsigned int> edges;
+        for (auto i = 0u; i + 2 < indexCount; i += 3) {
+            for (auto corner = 0u; corner < 3; ++corner) {
+                const std::uint64_t from = welded[indices[i + corner]];
+                const std::uint64_t to = welded[indices[i + (corner + 1) % 3]];
+                if (from != to) {
+                    ++edges[from << 32 | to];
+                }
+            }
+        }
+        for (const auto& edge : edges) {
+            const auto opposite = edges.find(edge.first << 32 | edge.first >> 32);
+            if (edge.second != 1 || opposite == edges.end() || opposite->second != 1) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
 
 Mesh::Mesh(aiMesh* meshNode, const shared_ptr<GameObject>& parent)
     : Component("mesh", parent)
 {
-    loadMesh(meshNode);
+    CookedGeometry cooked;
+    cook(meshNode, cooked);
+    upload(cooked.geometry);
+}
+
+Mesh::Mesh(const Geometry& geometry, const shared_ptr<GameObject>& parent)
+    : Component("mesh", parent)
+{
+    upload(geometry);
 }
 
 void Mesh::objectMounted()
@@ -23,6 +160,11 @@ void Mesh::objectMounted()
     for (const auto& shader : shaderCompList) {
         shaderList.push_back(static_pointer_cast<Shader>(shader));
     }
+    boneTransforms.clear();
+    for (const auto& boneName : boneNames) {
+        const auto bone = parent->findObject(boneName);
+        boneTransforms.push_back(bone ? bone->getTransform() : nullptr);
+    }
 }
 
 ComponentKey Mesh::getComponentKey()
@@ -32,67 +174,159 @@ ComponentKey Mesh::getComponentKey()
 
 void Mesh::shadowMappingRender(const shared_ptr<ShaderFastMeshRender>& depthShader)
 {
-    if (!doNotRender) {
-        const auto transform = parent->getTransform();
-        glm::mat4 model;
-        model = translate(model, transform->getPosition());
-        model *= mat4_cast(transform->getRotation());
-        model = scale(model, transform->getScale());
-        if (insideFrustum(depthShader->getCurrentMatrixViewProjection(), model)) {
-            depthShader->setMat4("model", model);
-            glBindVertexArray(vao);
-            glDrawElements(GL_TRIANGLES, indexSize, GL_UNSIGNED_INT, nullptr);
-            glBindVertexArray(0);
-        }
-    }
+    drawDepth(depthShader, parent->getTransform()->getModelMatrix());
 }
 
-void Mesh::render()
+void Mesh::drawDepth(const shared_ptr<ShaderFastMeshRender>& depthShader, const glm::mat4& model, const unsigned int lod)
 {
-    const auto currentCamera = parent->currentCamera;
-    const auto projection = glm::perspective(currentCamera->horizontalFOV, currentCamera->screenWidth / currentCamera->screenHeight, constants::NEAR_RENDER_PLANE, constants::FAR_RENDER_PLANE);
-    const auto view = currentCamera->getViewMatrix();
-    const auto transform = parent->getTransform();
+    if (!doNotRender && insideFrustum(depthShader->getCurrentMatrixViewProjection(), model)) {
+        depthShader->setMat4("model", model);
+        bindSkin(*depthShader);
+        bindVertexFormat(*depthShader);
+        glBindVertexArray(depthVao);
+        const auto& level = lods[std::min<size_t>(lod, lods.size() - 1)];
+        const DrawRange range{ level.indexOffset, level.indexCount };
+        drawRanges(&range, 1);
+        glBindVertexArray(0);
+    }
+}
 
-    glm::mat4 model;
-    model = translate(model, transform->getPosition());
-    model *= mat4_cast(transform->getRotation());
-    model = scale(model, transform->getScale());
+void Mesh::drawWith(const Shader& shader) const
+{
+    bindVertexFormat(shader);
+    glBindVertexArray(vao);
+    const DrawRange range{ lods[0].indexOffset, lods[0].indexCount };
+    drawRanges(&range, 1);
+    glBindVertexArray(0);
+}
 
-    this->enabled = insideFrustum(projection * view, model);
-    if (!doNotRender && this->enabled && !renderInLateRender) {
-        forceRenderMesh();
-    }
+unsigned int Mesh::getStateKey() const
+{
+    return shaderList.empty() ? 0 : shaderList.front()->ID;
 }
 
-void Mesh::lateRender()
+void Mesh::draw(const RenderView& view, const glm::mat4& model, const unsigned int lod)
 {
-    if (!doNotRender && this->enabled && renderInLateRender) {
-        forceRenderMesh();
-    }
+    const auto& level = lods[std::min<size_t>(lod, lods.size() - 1)];
+    const DrawRange range{ level.indexOffset, level.indexCount };
+    draw(view, model, &range, 1);
 }
 
-void Mesh::forceRenderMesh()
+void Mesh::draw(const RenderView& view, const glm::mat4& model, const DrawRange* ranges, const size_t rangeCount)
 {
+    // Culling is off for everything else, a mirroring transform turns the front faces around
+    const auto cullBackFaces = closed && glm::determinant(glm::mat3(model)) > 0.0f;
+    if (cullBackFaces) {
+        glEnable(GL_CULL_FACE);
+    }
     for (const auto& shader : shaderList) {
 
         if (shader->enabled) {
             switch (shader->getShaderType()) {
             case MaterialDefaultShader: {
-                static_pointer_cast<ShaderMaterialDefault>(shader)->setup(material, static_pointer_cast<Mesh>(shared_from_this()));
+                static_pointer_cast<ShaderMaterialDefault>(shader)->setup(material, model, view);
+                bindSkin(*shader);
+                bindVertexFormat(*shader);
             }
             break;
             case WaterShader: {
-                static_pointer_cast<ShaderWater>(shader)->setup(this);
+                static_pointer_cast<ShaderWater>(shader)->setup(model, view);
+                bindVertexFormat(*shader);
             }
             break;
             default: ;
             }
             glBindVertexArray(vao);
-            glDrawElements(GL_TRIANGLES, indexSize, GL_UNSIGNED_INT, nullptr);
+            drawRanges(ranges, rangeCount);
             glBindVertexArray(0);
         }
     }
+    if (cullBackFaces) {
+        glDisable(GL_CULL_FACE);
+    }
+}
+
+void Mesh::drawRanges(const DrawRange* ranges, const size_t rangeCount) const
+{
+    const auto indexBytes = indexType == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(unsigned int);
+    if (rangeCount == 1) {
+        glDrawElements(GL_TRIANGLES, ranges[0].indexCount, indexType, reinterpret_cast<void*>(ranges[0].indexOffset * indexBytes));
+        return;
+    }
+    // Only the GL thread draws, so every mesh can share the argument arrays
+    static vector<GLsizei> counts;
+    static vector<const void*> offsets;
+    counts.resize(rangeCount);
+    offsets.resize(rangeCount);
+    for (size_t i = 0; i < rangeCount; ++i) {
+        counts[i] = static_cast<GLsizei>(ranges[i].indexCount);
+        offsets[i] = reinterpret_cast<const void*>(ranges[i].indexOffset * indexBytes);
+    }
+    glMultiDrawElements(GL_TRIANGLES, counts.data(), indexType, offsets.data(), static_cast<GLsizei>(rangeCount));
+}
+
+size_t Mesh::cullClusters(const RenderView& view, const glm::mat4& model, const unsigned int lod, vector<DrawRange>& ranges) const
+{
+    const auto& level = lods[std::min<size_t>(lod, lods.size() - 1)];
+    if (!constants::CLUSTER_CULLING || level.clusterCount < 2 || isSkinned()) {
+        ranges.push_back(DrawRange{ level.indexOffset, level.indexCount });
+        return 1;
+    }
+    // Cones are tested in model space where they were built, which holds for any transform that keeps the
+    // winding. Only closed meshes have their back faces culled, open ones are seen from behind too. A multi view
+    // draw has an eye per layer, so it only gets the frustum test.
+    const auto modelBasis = glm::mat3(model);
+    const auto coneCulling = closed && !view.isMultiView() && glm::determinant(modelBasis) > 0.0f;
+    const auto eye = glm::vec3(glm::inverse(model) * glm::vec4(view.getPosition(), 1.0f));
+    const auto scale = std::max(glm::length(modelBasis[0]), std::max(glm::length(modelBasis[1]), glm::length(modelBasis[2])));
+    const auto first = ranges.size();
+    for (auto i = level.clusterOffset; i < level.clusterOffset + level.clusterCount; ++i) {
+        const auto& cluster = clusters[i];
+        if (coneCulling) {
+            const auto toCluster = cluster.center - eye;
+            if (glm::dot(toCluster, cluster.coneAxis) >= cluster.coneCutoff * glm::length(toCluster) + cluster.radius) {
+                continue;
+            }
+        }
+        if (!view.isVisible(glm::vec3(model * glm::vec4(cluster.center, 1.0f)), cluster.radius * scale)) {
+            continue;
+        }
+        if (ranges.size() > first && ranges.back().indexOffset + ranges.back().indexCount == cluster.indexOffset) {
+            ranges.back().indexCount += cluster.indexCount;
+        } else {
+            ranges.push_back(DrawRange{ cluster.indexOffset, cluster.indexCount });
+        }
+    }
+    return ranges.size() - first;
+}
+
+unsigned int Mesh::selectLod(const float screenSize, const LodPass pass)
+{
+    if (lods.size() < 2) {
+        return 0;
+    }
+    auto tolerance = constants::LOD_PIXEL_ERROR;
+    if (pass == LodPassShadow) {
+        tolerance = constants::LOD_SHADOW_PIXEL_ERROR;
+    } else if (pass == LodPassReflection || pass == LodPassRefraction) {
+        tolerance = constants::LOD_WATER_PIXEL_ERROR;
+    }
+    const auto pixels = screenSize * constants::SCREEN_HEIGHT;
+    // Several views of one pass may select at once, the level is only a hint so any of their writes will do
+    auto lod = std::min<unsigned int>(lodLevels[pass].load(std::memory_order_relaxed), static_cast<unsigned int>(lods.size() - 1));
+    while (lod + 1 < lods.size() && lods[lod + 1].error * pixels <= tolerance * (1.0f - constants::LOD_HYSTERESIS)) {
+        ++lod;
+    }
+    while (lod > 0 && lods[lod].error * pixels > tolerance * (1.0f + constants::LOD_HYSTERESIS)) {
+        --lod;
+    }
+    lodLevels[pass].store(static_cast<std::uint8_t>(lod), std::memory_order_relaxed);
+    return lod;
+}
+
+unsigned int Mesh::getLodCount() const
+{
+    return static_cast<unsigned int>(lods.size());
 }
 
 void Mesh::update() {}
@@ -100,20 +334,22 @@ void Mesh::update() {}
 
 Mesh::~Mesh()
 {
-    glDeleteBuffers(1, &vao);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteVertexArrays(1, &depthVao);
     glDeleteBuffers(1, &indexBuffer);
+    glDeleteBuffers(1, &positionBuffer);
     glDeleteBuffers(1, &vertexBuffer);
+    if (skinBuffer) {
+        glDeleteBuffers(1, &skinBuffer);
+        glDeleteBuffers(1, &paletteBuffer);
+    }
 }
 
-bool Mesh::insideFrustum(const glm::mat4& projectionViewMatrix, const glm::mat4& modelTransformation) const
+void Mesh::getWorldBounds(const glm::mat4& modelTransformation, glm::vec3& worldMin, glm::vec3& worldMax) const
 {
-    // AABB calculation
-
     glm::vec4 points[8];
     // bottomLeftBack
     points[0] = (modelTransformation * glm::vec4(minPoints.x, minPoints.y, minPoints.z, 1.0));
-    auto auxMinPoints = glm::vec3(points[0].x, points[0].y, points[0].z);
-    auto auxMaxPoints = glm::vec3(points[0].x, points[0].y, points[0].z);
     // bottomRightBack
     points[1] = (modelTransformation * glm::vec4(maxPoints.x, minPoints.y, minPoints.z, 1.0));
     // bottomLeftFront
@@ -129,26 +365,49 @@ bool Mesh::insideFrustum(const glm::mat4& projectionViewMatrix, const glm::mat4&
     // topRightFront
     points[7] = (modelTransformation * glm::vec4(maxPoints.x, maxPoints.y, maxPoints.z, 1.0));
 
+    worldMin = glm::vec3(points[0].x, points[0].y, points[0].z);
+    worldMax = worldMin;
     for (auto point : points) {
-        if (auxMinPoints.x > point.x) {
-            auxMinPoints.x = point.x;
+        if (worldMin.x > point.x) {
+            worldMin.x = point.x;
         }
-        if (auxMinPoints.y > point.y) {
-            auxMinPoints.y = point.y;
+        if (worldMin.y > point.y) {
+            worldMin.y = point.y;
         }
-        if (auxMinPoints.z > point.z) {
-            auxMinPoints.z = point.z;
+        if (worldMin.z > point.z) {
+            worldMin.z = point.z;
         }
-        if (auxMaxPoints.x < point.x) {
-            auxMaxPoints.x = point.x;
+        if (worldMax.x < point.x) {
+            worldMax.x = point.x;
         }
-        if (auxMaxPoints.y < point.y) {
-            auxMaxPoints.y = point.y;
+        if (worldMax.y < point.y) {
+            worldMax.y = point.y;
         }
-        if (auxMaxPoints.z < point.z) {
-            auxMaxPoints.z = point.z;
+        if (worldMax.z < point.z) {
+            worldMax.z = point.z;
         }
     }
+}
+
+bool Mesh::outsideClippingPlane(const glm::vec4& plane, const glm::mat4& modelTransformation) const
+{
+    glm::vec3 worldMin, worldMax;
+    getWorldBounds(modelTransformation, worldMin, worldMax);
+    // the AABB corner furthest along the plane normal; if even that one is clipped, the whole box is
+    const auto positiveVertex = glm::vec3(plane.x >= 0 ? worldMax.x : worldMin.x,
+                                          plane.y >= 0 ? worldMax.y : worldMin.y,
+                                          plane.z >= 0 ? worldMax.z : worldMin.z);
+    return dot(glm::vec4(positiveVertex, 1.0f), plane) < 0.0f;
+}
+
+bool Mesh::insideFrustum(const glm::mat4& projectionViewMatrix, const glm::mat4& modelTransformation) const
+{
+    // AABB calculation
+
+    glm::vec3 auxMinPoints, auxMaxPoints;
+    getWorldBounds(modelTransformation, auxMinPoints, auxMaxPoints);
+
+    glm::vec4 points[8];
     points[0] = projectionViewMatrix * glm::vec4(auxMinPoints.x, auxMinPoints.y, auxMinPoints.z, 1.0);
     // bottomRightBack
     points[1] = projectionViewMatrix * glm::vec4(auxMaxPoints.x, auxMinPoints.y, auxMinPoints.z, 1.0);
@@ -200,33 +459,36 @@ inline bool Mesh::checkFrustumCalc(glm::vec4 point)
             point.z < point.w);
 }
 
-void Mesh::loadMesh(aiMesh* meshNode)
+void Mesh::cook(aiMesh* meshNode, CookedGeometry& cooked)
 {
-    vertexCount = meshNode->mNumVertices;
-    std::vector<Vertex> vertices;
-    for (auto i = 0; i < vertexCount; i++) {
+    auto& geometry = cooked.geometry;
+    const auto vertexCount = meshNode->mNumVertices;
+    auto& vertices = cooked.vertices;
+    vertices.clear();
+    vertices.reserve(vertexCount);
+    for (auto i = 0u; i < vertexCount; i++) {
         Vertex vertex;
         glm::vec3 vector;
         vector.x = meshNode->mVertices[i].x;
         vector.y = meshNode->mVertices[i].y;
         vector.z = meshNode->mVertices[i].z;
-        if (i == 0 || vector.x < minPoints.x) {
-            minPoints.x = vector.x;
+        if (i == 0 || vector.x < geometry.minPoints.x) {
+            geometry.minPoints.x = vector.x;
         }
-        if (i == 0 || vector.y < minPoints.y) {
-            minPoints.y = vector.y;
+        if (i == 0 || vector.y < geometry.minPoints.y) {
+            geometry.minPoints.y = vector.y;
         }
-        if (i == 0 || vector.z < minPoints.z) {
-            minPoints.z = vector.z;
+        if (i == 0 || vector.z < geometry.minPoints.z) {
+            geometry.minPoints.z = vector.z;
         }
-        if (i == 0 || vector.x > maxPoints.x) {
-            maxPoints.x = vector.x;
+        if (i == 0 || vector.x > geometry.maxPoints.x) {
+            geometry.maxPoints.x = vector.x;
         }
-        if (i == 0 || vector.y > maxPoints.y) {
-            maxPoints.y = vector.y;
+        if (i == 0 || vector.y > geometry.maxPoints.y) {
+            geometry.maxPoints.y = vector.y;
         }
-        if (i == 0 || vector.z > maxPoints.z) {
-            maxPoints.z = vector.z;
+        if (i == 0 || vector.z > geometry.maxPoints.z) {
+            geometry.maxPoints.z = vector.z;
         }
         vertex.position = vector;
 
@@ -253,9 +515,9 @@ void Mesh::loadMesh(aiMesh* meshNode)
 
     // ****************** INDICES ***************
 
-    faceCount = meshNode->mNumFaces;
-    vector<unsigned int> indices;
-    for (unsigned int i = 0; i < faceCount; i++) {
+    auto& indices = cooked.indices;
+    indices.clear();
+    for (unsigned int i = 0; i < meshNode->mNumFaces; i++) {
         auto face = meshNode->mFaces[i];
         for (unsigned int j = 0; j < face.mNumIndices; j++) {
             indices.push_back(face.mIndices[j]);
@@ -263,38 +525,306 @@ void Mesh::loadMesh(aiMesh* meshNode)
         }
 
     }
-    indexSize = indices.size();
+
+    // ****************** SKIN ******************
+
+    cooked.skin.clear();
+    geometry.boneNames.clear();
+    geometry.boneOffsets.clear();
+    if (meshNode->HasBones() && meshNode->mNumBones > constants::MAX_SKIN_BONES) {
+        printf("Mesh %s has %u bones, more than the %u skinning supports, drawing it unskinned\n", meshNode->mName.C_Str(),
+               meshNode->mNumBones, constants::MAX_SKIN_BONES);
+    } else if (meshNode->HasBones()) {
+        // The four strongest influences of every vertex
+        std::vector<float> weights(vertexCount * 4, 0.0f);
+        std::vector<std::uint8_t> bones(vertexCount * 4, 0);
+        for (auto bone = 0u; bone < meshNode->mNumBones; ++bone) {
+            const auto aiBoneData = meshNode->mBones[bone];
+            geometry.boneNames.push_back(aiBoneData->mName.C_Str());
+            geometry.boneOffsets.push_back(toGlm(aiBoneData->mOffsetMatrix));
+            for (auto i = 0u; i < aiBoneData->mNumWeights; ++i) {
+                const auto& influence = aiBoneData->mWeights[i];
+                const auto slots = &weights[influence.mVertexId * 4];
+                const auto weakest = std::min_element(slots, slots + 4);
+                if (influence.mWeight > *weakest) {
+                    *weakest = influence.mWeight;
+                    bones[weakest - &weights[0]] = static_cast<std::uint8_t>(bone);
+                }
+            }
+        }
+        cooked.skin.resize(vertexCount);
+        for (auto i = 0u; i < vertexCount; ++i) {
+            auto total = 0.0f;
+            for (auto slot = 0; slot < 4; ++slot) {
+                total += weights[i * 4 + slot];
+            }
+            for (auto slot = 0; slot < 4; ++slot) {
+                cooked.skin[i].bones[slot] = bones[i * 4 + slot];
+                // Whatever rounding leaves short of 1 goes to the mesh's own transform in the shader
+                const auto weight = total > 0.0f ? weights[i * 4 + slot] / total : 0.0f;
+                cooked.skin[i].weights[slot] = static_cast<std::uint8_t>(std::lround(weight * 255.0f));
+            }
+        }
+    }
+
+    prepare(cooked, meshNode->mName.C_Str());
+}
+
+void Mesh::prepare(CookedGeometry& cooked, const string& name)
+{
+    auto& geometry = cooked.geometry;
+    auto& vertices = cooked.vertices;
+    auto& indices = cooked.indices;
+
+    // ****************** LEVELS OF DETAIL ******************
+
+    // Each level is simplified from the one before and appended to the index buffer, the errors add up
+    cooked.lods.assign(1, Lod{ 0, static_cast<unsigned int>(indices.size()), 0.0f, 0, 0 });
+    vector<unsigned int> level(indices);
+    vector<unsigned int> simplified;
+    auto lodError = 0.0f;
+    while (cooked.lods.size() < constants::LOD_COUNT && lodError < constants::LOD_MAX_ERROR) {
+        const auto target = static_cast<size_t>(level.size() / 3 * constants::LOD_REDUCTION) * 3;
+        lodError += MeshSimplifier::simplify(vertices, level, target, constants::LOD_MAX_ERROR - lodError, simplified);
+        // A level that barely saves anything isn't worth its indices
+        if (simplified.empty() || simplified.size() * 10 > level.size() * 9) {
+            break;
+        }
+        cooked.lods.push_back(Lod{ static_cast<unsigned int>(indices.size()), static_cast<unsigned int>(simplified.size()), lodError, 0, 0 });
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        level.swap(simplified);
+    }
+
+    if (constants::OPTIMIZE_MESHES) {
+        MeshOptimizer::optimize(cooked, name);
+    }
+    MeshClusterBuilder::build(cooked);
+
+    geometry.vertices = vertices.data();
+    geometry.vertexCount = static_cast<unsigned int>(vertices.size());
+    geometry.indices = indices.data();
+    geometry.indexCount = static_cast<unsigned int>(indices.size());
+    geometry.lods = cooked.lods.data();
+    geometry.lodCount = static_cast<unsigned int>(cooked.lods.size());
+    geometry.clusters = cooked.clusters.data();
+    geometry.clusterCount = static_cast<unsigned int>(cooked.clusters.size());
+    geometry.skin = cooked.skin.empty() ? nullptr : cooked.skin.data();
+    geometry.closed = isClosed(vertices, indices.data() + cooked.lods[0].indexOffset, cooked.lods[0].indexCount);
+}
+
+void Mesh::upload(const Geometry& geometry)
+{
+    vertexCount = geometry.vertexCount;
+    faceCount = (geometry.lodCount > 0 ? geometry.lods[0].indexCount : geometry.indexCount) / 3;
+    indexSize = geometry.indexCount;
+    minPoints = geometry.minPoints;
+    maxPoints = geometry.maxPoints;
+    boneNames = geometry.boneNames;
+    boneOffsets = geometry.boneOffsets;
+    closed = geometry.closed;
+    if (geometry.lodCount > 0) {
+        lods.assign(geometry.lods, geometry.lods + geometry.lodCount);
+    } else {
+        lods.assign(1, Lod{ 0, geometry.indexCount, 0.0f, 0, 0 });
+    }
+    clusters.assign(geometry.clusters, geometry.clusters + geometry.clusterCount);
+    for (auto& lodLevel : lodLevels) {
+        lodLevel.store(0, std::memory_order_relaxed);
+    }
+
+    // A pack has the vertices compressed already, only ones cooked from an aiMesh are converted here
+    compact = geometry.compactPositions != nullptr || constants::COMPACT_VERTEX_FORMAT;
+    auto compactPositions = geometry.compactPositions;
+    auto compactAttributes = geometry.compactAttributes;
+    auto shortIndices = geometry.shortIndices;
+    positionOffset = compact ? geometry.positionOffset : glm::vec3(0.0f);
+    positionScale = compact ? geometry.positionScale : glm::vec3(1.0f);
+    CompactGeometry converted;
+    if (compact && compactPositions == nullptr) {
+        compress(geometry, converted);
+        compactPositions = converted.positions.data();
+        compactAttributes = converted.attributes.data();
+        shortIndices = converted.shortIndices.empty() ? nullptr : converted.shortIndices.data();
+        positionOffset = converted.positionOffset;
+        positionScale = converted.positionScale;
+    }
 
     glGenBuffers(1, &indexBuffer);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indexSize, &indices[0], GL_STATIC_DRAW);
-
-    indices.clear();
+    if (shortIndices != nullptr) {
+        indexType = GL_UNSIGNED_SHORT;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(std::uint16_t) * indexSize, shortIndices, GL_STATIC_DRAW);
+    } else {
+        indexType = GL_UNSIGNED_INT;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indexSize, geometry.indices, GL_STATIC_DRAW);
+    }
 
-    // *************** VERTEX BUFFER ***************
+    // *************** VERTEX BUFFERS ***************
 
+    // Positions are a stream of their own, so the depth only VAO fetches nothing else
+    glGenBuffers(1, &positionBuffer);
     glGenBuffers(1, &vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    GLint positionSize;
+    GLenum positionType;
+    GLboolean positionNormalized;
+    if (compact) {
+        glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(CompactPosition), compactPositions, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(CompactAttributes), compactAttributes, GL_STATIC_DRAW);
+        positionSize = 4;
+        positionType = GL_UNSIGNED_SHORT;
+        positionNormalized = GL_TRUE;
+    } else {
+        vector<glm::vec3> positions(vertexCount);
+        vector<Attributes> attributes(vertexCount);
+        for (auto i = 0; i < vertexCount; ++i) {
+            positions[i] = geometry.vertices[i].position;
+            attributes[i] = Attributes{ geometry.vertices[i].normal, geometry.vertices[i].texCoords };
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(Attributes), attributes.data(), GL_STATIC_DRAW);
+        positionSize = 3;
+        positionType = GL_FLOAT;
+        positionNormalized = GL_FALSE;
+    }
 
-    vertices.clear();
+    if (geometry.skin) {
+        glGenBuffers(1, &skinBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, skinBuffer);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * sizeof(SkinVertex), geometry.skin, GL_STATIC_DRAW);
 
+        // Sized for the whole block the shaders declare, only the mesh's own bones are uploaded
+        glGenBuffers(1, &paletteBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, paletteBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, constants::MAX_SKIN_BONES * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // Both VAOs read positions, skin and indices, only the full one reads normals and texture coords
     glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    glGenVertexArrays(1, &depthVao);
+    for (const auto vertexArray : { vao, depthVao }) {
+        glBindVertexArray(vertexArray);
+        // vertex positions, compact ones decoded with positionOffset and positionScale
+        glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, positionSize, positionType, positionNormalized, 0, static_cast<void*>(nullptr));
+        // bone indices and weights, skinned meshes only
+        if (skinBuffer) {
+            glBindBuffer(GL_ARRAY_BUFFER, skinBuffer);
+            glEnableVertexAttribArray(3);
+            glVertexAttribIPointer(3, 4, GL_UNSIGNED_BYTE, sizeof(SkinVertex), reinterpret_cast<void*>(offsetof(SkinVertex, bones)));
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SkinVertex), reinterpret_cast<void*>(offsetof(SkinVertex, weights)));
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    }
 
-    // vertex positions
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), static_cast<void*>(nullptr));
-    // vertex normals
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, normal)));
-    // vertex texture coords
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, texCoords)));
-    // vertex index
-    glEnableVertexAttribArray(3);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    if (compact) {
+        // vertex normals, octahedral
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(CompactAttributes), reinterpret_cast<void*>(offsetof(CompactAttributes, normal)));
+        // vertex texture coords
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactAttributes), reinterpret_cast<void*>(offsetof(CompactAttributes, texCoords)));
+    } else {
+        // vertex normals
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Attributes), reinterpret_cast<void*>(offsetof(Attributes, normal)));
+        // vertex texture coords
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Attributes), reinterpret_cast<void*>(offsetof(Attributes, texCoords)));
+    }
 
     glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
+
+bool Mesh::isSkinned() const
+{
+    return skinBuffer != 0;
+}
+
+void Mesh::computeSkinPalette(std::vector<glm::mat4>& palette) const
+{
+    palette.resize(boneNames.size());
+    const auto inverseModel = glm::inverse(parent->getTransform()->getModelMatrix());
+    for (auto i = 0u; i < palette.size(); ++i) {
+        const auto& bone = i < boneTransforms.size() ? boneTransforms[i] : nullptr;
+        palette[i] = bone ? inverseModel * bone->getModelMatrix() * boneOffsets[i] : glm::mat4(1.0f);
+    }
+}
+
+void Mesh::uploadSkinPalette(const std::vector<glm::mat4>& palette) const
+{
+    if (!isSkinned() || palette.empty()) {
+        return;
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, paletteBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, palette.size() * sizeof(glm::mat4), &palette[0]);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void Mesh::compress(const Geometry& geometry, CompactGeometry& compact)
+{
+    compact.positionOffset = geometry.minPoints;
+    compact.positionScale = geometry.maxPoints - geometry.minPoints;
+    compact.positions.resize(geometry.vertexCount);
+    compact.attributes.resize(geometry.vertexCount);
+    for (auto i = 0u; i < geometry.vertexCount; ++i) {
+        const auto& vertex = geometry.vertices[i];
+        auto& position = compact.positions[i].position;
+        for (auto axis = 0; axis < 3; ++axis) {
+            const auto extent = compact.positionScale[axis];
+            position[axis] = toUnorm16(extent > 0.0f ? (vertex.position[axis] - compact.positionOffset[axis]) / extent : 0.0f);
+        }
+        position[3] = 0;
+        auto& attributes = compact.attributes[i];
+        toOctahedral(vertex.normal, attributes.normal);
+        attributes.texCoords[0] = toHalf(vertex.texCoords.x);
+        attributes.texCoords[1] = toHalf(vertex.texCoords.y);
+    }
+    compact.shortIndices.clear();
+    if (geometry.vertexCount <= std::numeric_limits<std::uint16_t>::max() + 1u) {
+        compact.shortIndices.assign(geometry.indices, geometry.indices + geometry.indexCount);
+    }
+}
+
+Mesh::Vertex Mesh::readVertex(const Geometry& geometry, const unsigned int vertex)
+{
+    if (geometry.vertices != nullptr) {
+        return geometry.vertices[vertex];
+    }
+    const auto& position = geometry.compactPositions[vertex].position;
+    const auto& attributes = geometry.compactAttributes[vertex];
+    Vertex decoded;
+    for (auto axis = 0; axis < 3; ++axis) {
+        decoded.position[axis] = geometry.positionOffset[axis] + position[axis] / 65535.0f * geometry.positionScale[axis];
+    }
+    decoded.normal = fromOctahedral(attributes.normal);
+    decoded.texCoords = glm::vec2(fromHalf(attributes.texCoords[0]), fromHalf(attributes.texCoords[1]));
+    return decoded;
+}
+
+unsigned int Mesh::readIndex(const Geometry& geometry, const unsigned int index)
+{
+    return geometry.shortIndices != nullptr ? geometry.shortIndices[index] : geometry.indices[index];
+}
+
+void Mesh::bindVertexFormat(const Shader& shader) const
+{
+    shader.setBool("compactVertex", compact);
+    shader.setVec3("positionOffset", positionOffset);
+    shader.setVec3("positionScale", positionScale);
+}
+
+void Mesh::bindSkin(const Shader& shader) const
+{
+    shader.setBool("skinned", isSkinned());
+    if (isSkinned()) {
+        glBindBufferBase(GL_UNIFORM_BUFFER, constants::BONE_PALETTE_BINDING, paletteBuffer);
+    }
+}
@@ -1,21 +1,148 @@
 #pragma once
 #include "OpenGLImports.h"
 #include "Component.h"
+#include "RenderView.h"
 #include <glm/glm.hpp>
 #include <assimp/mesh.h>
+#include <atomic>
+#include <cstdint>
 #include <list>
+#include <vector>
 
 class Material;
 class Shader;
+class RenderView;
+class Transform;
 
 class Mesh : public Component {
 public:
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoords;
+    };
+
+    // Separate stream, only skinned meshes have it. Weights are normalized bytes, 255 in total up to rounding.
+    struct SkinVertex {
+        std::uint8_t bones[4];
+        std::uint8_t weights[4];
+    };
+
+    // A range of the index buffer, all levels index the same vertices. error is the surface deviation from the
+    // full mesh relative to the bounds diagonal, so it projects to pixels with the screen size of the bounds.
+    struct Lod {
+        unsigned int indexOffset;
+        unsigned int indexCount;
+        float error;
+        unsigned int clusterOffset; // the clusters tiling indexOffset to indexOffset + indexCount, in order
+        unsigned int clusterCount;
+    };
+
+    // A patch of a few dozen neighbouring triangles of one level, in model space. It faces away from an eye
+    // wherever dot(center - eye, coneAxis) >= coneCutoff * length(center - eye) + radius.
+    struct Cluster {
+        glm::vec3 center;
+        float radius;
+        glm::vec3 coneAxis;
+        float coneCutoff; // sine of the normal cone's half angle, 1 when no eye can be ruled out
+        unsigned int indexOffset;
+        unsigned int indexCount;
+    };
+
+    // The vertex format COMPACT_VERTEX_FORMAT uploads. Positions are fractions of the bounds, the 4th component
+    // is padding.
+    struct CompactPosition {
+        std::uint16_t position[4];
+    };
+
+    // Octahedral encoded normal, half float UVs
+    struct CompactAttributes {
+        std::int16_t normal[2];
+        std::uint16_t texCoords[2];
+    };
+
+    // Part of the index buffer to draw, several of them go to one multi draw
+    struct DrawRange {
+        unsigned int indexOffset;
+        unsigned int indexCount;
+    };
+
+    // GPU ready arrays, either cooked from an aiMesh or pointing straight into a mapped scene pack. A pack holds
+    // the vertices compressed already: vertices is null then, and indices too when they fit shortIndices.
+    struct Geometry {
+        const Vertex* vertices = nullptr;
+        unsigned int vertexCount = 0;
+        const unsigned int* indices = nullptr;
+        unsigned int indexCount = 0;
+        const CompactPosition* compactPositions = nullptr;
+        const CompactAttributes* compactAttributes = nullptr;
+        const std::uint16_t* shortIndices = nullptr;
+        glm::vec3 positionOffset; // decodes compactPositions
+        glm::vec3 positionScale;
+        const Lod* lods = nullptr; // finest first, none means the whole index buffer is one level
+        unsigned int lodCount = 0;
+        const Cluster* clusters = nullptr;
+        unsigned int clusterCount = 0;
+        const SkinVertex* skin = nullptr; // one per vertex, null when not skinned
+        bool closed = false; // a watertight surface, only its front faces can ever be seen
+        glm::vec3 minPoints;
+        glm::vec3 maxPoints;
+        vector<string> boneNames;
+        vector<glm::mat4> boneOffsets;
+    };
+
+    // Owns the arrays a Geometry points to
+    struct CookedGeometry {
+        vector<Vertex> vertices;
+        vector<unsigned int> indices;
+        vector<SkinVertex> skin;
+        vector<Lod> lods;
+        vector<Cluster> clusters;
+        Geometry geometry;
+    };
+
+    // What upload converts a Geometry's float vertices to, done ahead when cooking a pack. shortIndices is left
+    // empty when the vertices don't fit 16 bit indices.
+    struct CompactGeometry {
+        vector<CompactPosition> positions;
+        vector<CompactAttributes> attributes;
+        vector<std::uint16_t> shortIndices;
+        glm::vec3 positionOffset;
+        glm::vec3 positionScale;
+    };
+
     Mesh(aiMesh* meshNode, const shared_ptr<GameObject>& parent);
+    Mesh(const Geometry& geometry, const shared_ptr<GameObject>& parent);
+    // The CPU side of loading, needs no GL context
+    static void cook(aiMesh* meshNode, CookedGeometry& cooked);
+    // The part of cooking after the arrays are filled: levels of detail, reordering, clusters. Bounds and bones
+    // are left as they are.
+    static void prepare(CookedGeometry& cooked, const string& name);
+    static void compress(const Geometry& geometry, CompactGeometry& compact);
+    // Either vertex format read back as floats, for CPU side users like HLOD
+    static Vertex readVertex(const Geometry& geometry, unsigned int vertex);
+    static unsigned int readIndex(const Geometry& geometry, unsigned int index);
     ComponentKey getComponentKey() override;
     void shadowMappingRender(const shared_ptr<ShaderFastMeshRender>& depthShader) override;
-    void render() override;
-    void lateRender() override;
-    void forceRenderMesh();
+    // Scene meshes are drawn through DrawLists, recorded on worker threads from the frame's SceneSnapshot
+    void draw(const RenderView& view, const glm::mat4& model, unsigned int lod = 0);
+    void draw(const RenderView& view, const glm::mat4& model, const DrawRange* ranges, size_t rangeCount);
+    void drawDepth(const shared_ptr<ShaderFastMeshRender>& depthShader, const glm::mat4& model, unsigned int lod = 0);
+    // The full level with a program the caller set up, for renders outside the passes like impostor baking
+    void drawWith(const Shader& shader) const;
+    // Coarsest level whose error stays under the pass's pixel tolerance at this screen size. Every pass keeps its
+    // own current level and only leaves it once the error is a margin past the tolerance, so meshes near a
+    // switching distance don't flicker between levels. Called from the draw recording jobs.
+    unsigned int selectLod(float screenSize, LodPass pass);
+    unsigned int getLodCount() const;
+    // Appends the index ranges of the level's clusters that are inside the view and can face it, neighbours merged.
+    // Skinned meshes move away from their cluster bounds and always get the whole level. Returns the ranges added.
+    size_t cullClusters(const RenderView& view, const glm::mat4& model, unsigned int lod, vector<DrawRange>& ranges) const;
+    unsigned int getStateKey() const;
+    // Skinned meshes are deformed on the GPU by a palette of bone matrices, palette[i] = inverse(model) * bone * offset
+    bool isSkinned() const;
+    void computeSkinPalette(std::vector<glm::mat4>& palette) const;
+    void uploadSkinPalette(const std::vector<glm::mat4>& palette) const;
     void update() override;
     void objectMounted() override;
     ~Mesh();
@@ -27,19 +154,26 @@ public:
 
     bool renderInLateRender = false;
     bool doNotRender = false;
+    // Screen height fraction covered in the last camera pass, 0 when it was culled. Written between frames.
+    float screenSize = 1.0f;
 
     bool insideFrustum(const glm::mat4& projectionViewMatrix, const glm::mat4& modelTransformation) const;
+    bool outsideClippingPlane(const glm::vec4& plane, const glm::mat4& modelTransformation) const;
+    void getWorldBounds(const glm::mat4& modelTransformation, glm::vec3& worldMin, glm::vec3& worldMax) const;
     inline static bool checkFrustumCalc(glm::vec4 point);
 
 private:
 
-    struct Vertex {
-        glm::vec3 position;
+    // Uploaded deinterleaved: positions alone in one buffer, the rest in another
+    struct Attributes {
         glm::vec3 normal;
         glm::vec2 texCoords;
     };
 
-    void loadMesh(aiMesh* meshNode);
+    void upload(const Geometry& geometry);
+    void drawRanges(const DrawRange* ranges, size_t rangeCount) const;
+    void bindSkin(const Shader& shader) const;
+    void bindVertexFormat(const Shader& shader) const;
 
     string error = "";
 
@@ -47,9 +181,26 @@ private:
     unsigned int faceCount;
     int indexSize;
 
+    vector<Lod> lods;
+    vector<Cluster> clusters;
+    std::atomic<std::uint8_t> lodLevels[LodPassCount];
+
     GLuint vao;
+    GLuint depthVao; // positions and skin only, for the shadow pass
+    GLenum indexType = GL_UNSIGNED_INT;
+    bool compact = false;
+    bool closed = false; // back faces and back facing clusters are culled, open meshes are seen from both sides
+    glm::vec3 positionOffset; // decodes compact positions, identity for float ones
+    glm::vec3 positionScale;
     GLuint indexBuffer;
-    GLuint vertexBuffer;
+    GLuint positionBuffer;
+    GLuint vertexBuffer; // normals and texture coords
+    GLuint skinBuffer = 0;
+    GLuint paletteBuffer = 0;
+
+    vector<string> boneNames;
+    vector<glm::mat4> boneOffsets;
+    vector<shared_ptr<Transform>> boneTransforms; // found by name once mounted, null when missing
 
     list<shared_ptr<Shader>> shaderList;
 };
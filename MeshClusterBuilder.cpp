@@ -0,0 +1,170 @@
+#include "MeshClusterBuilder.h"
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+
+void MeshClusterBuilder::build(Mesh::CookedGeometry& cooked, const unsigned int maxVertices, const unsigned int maxTriangles)
+{
+    if (cooked.lods.empty()) {
+        cooked.lods.assign(1, Mesh::Lod{ 0, static_cast<unsigned int>(cooked.indices.size()), 0.0f, 0, 0 });
+    }
+    const auto vertexCount = static_cast<unsigned int>(cooked.vertices.size());
+    cooked.clusters.clear();
+    // Cluster each vertex was last added to, plus one
+    vector<unsigned int> vertexCluster(vertexCount, 0);
+    vector<unsigned int> triangleOffsets(vertexCount + 1);
+    vector<unsigned int> vertexTriangles;
+    vector<unsigned int> candidates;
+    vector<unsigned int> members;
+    vector<unsigned int> result;
+    for (auto& lod : cooked.lods) {
+        lod.clusterOffset = static_cast<unsigned int>(cooked.clusters.size());
+        lod.clusterCount = 0;
+        if (lod.indexCount == 0) {
+            continue;
+        }
+        const auto indices = &cooked.indices[lod.indexOffset];
+        const auto triangleCount = lod.indexCount / 3;
+
+        // Triangles of this level around every vertex
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (auto i = 0u; i < lod.indexCount; ++i) {
+            ++triangleOffsets[indices[i] + 1];
+        }
+        for (auto i = 0u; i < vertexCount; ++i) {
+            triangleOffsets[i + 1] += triangleOffsets[i];
+        }
+        vertexTriangles.resize(lod.indexCount);
+        {
+            vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+            for (auto i = 0u; i < lod.indexCount; ++i) {
+                vertexTriangles[fill[indices[i]]++] = i / 3;
+            }
+        }
+
+        vector<bool> taken(triangleCount, false);
+        result.clear();
+        result.reserve(lod.indexCount);
+        auto cursor = 0u;
+        while (true) {
+            while (cursor < triangleCount && taken[cursor]) {
+                ++cursor;
+            }
+            if (cursor == triangleCount) {
+                break;
+            }
+            const auto stamp = static_cast<unsigned int>(cooked.clusters.size()) + 1;
+            auto clusterVertices = 0u;
+            members.clear();
+            candidates.clear();
+            auto next = static_cast<int>(cursor);
+            while (next >= 0) {
+                const auto triangle = static_cast<unsigned int>(next);
+                taken[triangle] = true;
+                members.push_back(triangle);
+                for (auto corner = 0; corner < 3; ++corner) {
+                    const auto vertex = indices[triangle * 3 + corner];
+                    if (vertexCluster[vertex] == stamp) {
+                        continue;
+                    }
+                    vertexCluster[vertex] = stamp;
+                    ++clusterVertices;
+                    for (auto i = triangleOffsets[vertex]; i < triangleOffsets[vertex + 1]; ++i) {
+                        if (!taken[vertexTriangles[i]]) {
+                            candidates.push_back(vertexTriangles[i]);
+                        }
+                    }
+                }
+                if (members.size() >= maxTriangles) {
+                    break;
+                }
+
+                // Fewest new vertices first, then the one the optimizer placed earliest
+                next = -1;
+                auto bestNew = 4u;
+                auto kept = 0u;
+                for (const auto candidate : candidates) {
+                    if (taken[candidate]) {
+                        continue;
+                    }
+                    candidates[kept++] = candidate;
+                    auto newVertices = 0u;
+                    for (auto corner = 0; corner < 3; ++corner) {
+                        newVertices += vertexCluster[indices[candidate * 3 + corner]] == stamp ? 0 : 1;
+                    }
+                    if (clusterVertices + newVertices > maxVertices) {
+                        continue;
+                    }
+                    if (newVertices < bestNew || (newVertices == bestNew && candidate < static_cast<unsigned int>(next))) {
+                        bestNew = newVertices;
+                        next = static_cast<int>(candidate);
+                    }
+                }
+                candidates.resize(kept);
+            }
+
+            std::sort(members.begin(), members.end());
+            Mesh::Cluster cluster;
+            cluster.indexOffset = lod.indexOffset + static_cast<unsigned int>(result.size());
+            cluster.indexCount = static_cast<unsigned int>(members.size() * 3);
+            for (const auto triangle : members) {
+                result.insert(result.end(), indices + triangle * 3, indices + triangle * 3 + 3);
+            }
+            cooked.clusters.push_back(cluster);
+        }
+        std::copy(result.begin(), result.end(), indices);
+        lod.clusterCount = static_cast<unsigned int>(cooked.clusters.size()) - lod.clusterOffset;
+    }
+
+    for (auto& cluster : cooked.clusters) {
+        computeBounds(cooked.vertices, cooked.indices, cluster);
+    }
+}
+
+void MeshClusterBuilder::computeBounds(const vector<Mesh::Vertex>& vertices, const vector<unsigned int>& indices, Mesh::Cluster& cluster)
+{
+    const auto begin = cluster.indexOffset;
+    const auto end = cluster.indexOffset + cluster.indexCount;
+    if (begin == end) {
+        cluster.center = glm::vec3(0.0f);
+        cluster.radius = 0.0f;
+        cluster.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+        cluster.coneCutoff = 1.0f;
+        return;
+    }
+
+    auto boundsMin = vertices[indices[begin]].position;
+    auto boundsMax = boundsMin;
+    for (auto i = begin; i < end; ++i) {
+        boundsMin = glm::min(boundsMin, vertices[indices[i]].position);
+        boundsMax = glm::max(boundsMax, vertices[indices[i]].position);
+    }
+    cluster.center = (boundsMin + boundsMax) * 0.5f;
+    cluster.radius = 0.0f;
+    for (auto i = begin; i < end; ++i) {
+        cluster.radius = std::max(cluster.radius, glm::length(vertices[indices[i]].position - cluster.center));
+    }
+
+    // Face normals, the winding decides what the rasterizer culls, not the shading normals
+    vector<glm::vec3> normals;
+    auto axis = glm::vec3(0.0f);
+    for (auto i = begin; i + 2 < end; i += 3) {
+        const auto& a = vertices[indices[i]].position;
+        const auto& b = vertices[indices[i + 1]].position;
+        const auto& c = vertices[indices[i + 2]].position;
+        const auto normal = glm::cross(b - a, c - a);
+        const auto length = glm::length(normal);
+        if (length > 0.0f) {
+            normals.push_back(normal / length);
+            axis += normals.back();
+        }
+    }
+    const auto axisLength = glm::length(axis);
+    cluster.coneAxis = axisLength > 0.0f ? axis / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+    auto minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+    for (const auto& normal : normals) {
+        minDot = std::min(minDot, glm::dot(normal, cluster.coneAxis));
+    }
+    // Cones of 90 degrees or more face some eye anywhere
+    cluster.coneCutoff = minDot <= 0.0f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "Mesh.h"
+#include "Constants.h"
+
+// Splits every level of detail of a cooked mesh into clusters of nearby triangles, small enough that culling
+// them one by one pays off on large meshes. A cluster grows from the first triangle the optimizer ordered that
+// isn't taken yet, adding the adjacent triangle that brings in the fewest new vertices, so clusters are compact
+// patches. Triangles keep their optimized order inside a cluster and clusters the order of their first triangle.
+class MeshClusterBuilder {
+public:
+    static void build(Mesh::CookedGeometry& cooked, unsigned int maxVertices = constants::CLUSTER_MAX_VERTICES,
+                      unsigned int maxTriangles = constants::CLUSTER_MAX_TRIANGLES);
+    // Bounding sphere and normal cone of the triangles the cluster's index range covers
+    static void computeBounds(const vector<Mesh::Vertex>& vertices, const vector<unsigned int>& indices, Mesh::Cluster& cluster);
+};
@@ -0,0 +1,314 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cstdio>
+#include <glm/glm.hpp>
+
+namespace {
+    // FIFO post transform cache, the model the statistics and the overdraw splits are measured with
+    class CacheSimulator {
+    public:
+        CacheSimulator(const unsigned int vertexCount, const unsigned int cacheSize)
+            : timestamps(vertexCount, 0), time(cacheSize + 1), size(cacheSize) {}
+
+        // Misses of one triangle
+        unsigned int add(const unsigned int* triangle)
+        {
+            auto misses = 0u;
+            for (auto i = 0; i < 3; ++i) {
+                const auto vertex = triangle[i];
+                if (time - timestamps[vertex] > size) {
+                    timestamps[vertex] = time++;
+                    ++misses;
+                }
+            }
+            return misses;
+        }
+
+        void reset()
+        {
+            // Moving the clock past every entry empties the cache
+            time += size;
+        }
+
+    private:
+        vector<unsigned int> timestamps;
+        unsigned int time;
+        unsigned int size;
+    };
+
+    // Triangles using each vertex, as offsets into one flat array
+    struct Adjacency {
+        vector<unsigned int> offsets;
+        vector<unsigned int> triangles;
+
+        Adjacency(const vector<unsigned int>& indices, const unsigned int vertexCount)
+            : offsets(vertexCount + 1, 0), triangles(indices.size())
+        {
+            for (const auto index : indices) {
+                ++offsets[index + 1];
+            }
+            for (auto i = 0u; i < vertexCount; ++i) {
+                offsets[i + 1] += offsets[i];
+            }
+            vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+            for (auto i = 0u; i < indices.size(); ++i) {
+                triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+            }
+        }
+    };
+}
+
+MeshOptimizer::CacheStats MeshOptimizer::analyzeVertexCache(const vector<unsigned int>& indices, const unsigned int vertexCount,
+                                                            const unsigned int cacheSize)
+{
+    const auto triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0) {
+        return CacheStats{ 0.0f, 0.0f };
+    }
+    CacheSimulator cache(vertexCount, cacheSize);
+    auto misses = 0u;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        misses += cache.add(&indices[i]);
+    }
+    return CacheStats{ static_cast<float>(misses) / triangleCount, static_cast<float>(misses) / vertexCount };
+}
+
+void MeshOptimizer::optimizeVertexCache(vector<unsigned int>& indices, const unsigned int vertexCount, vector<unsigned int>& clusters,
+                                        const unsigned int cacheSize)
+{
+    clusters.clear();
+    const auto triangleCount = static_cast<unsigned int>(indices.size() / 3);
+    if (triangleCount == 0) {
+        return;
+    }
+    const Adjacency adjacency(indices, vertexCount);
+    vector<unsigned int> liveTriangles(vertexCount);
+    for (auto i = 0u; i < vertexCount; ++i) {
+        liveTriangles[i] = adjacency.offsets[i + 1] - adjacency.offsets[i];
+    }
+    vector<unsigned int> cacheTimes(vertexCount, 0);
+    vector<bool> emitted(triangleCount, false);
+    vector<unsigned int> deadEnds;
+    vector<unsigned int> candidates;
+    vector<unsigned int> result;
+    result.reserve(indices.size());
+    auto time = cacheSize + 1;
+    auto cursor = 0u;
+
+    // Vertices with triangles left, most recently used first, then the lowest numbered ones
+    const auto skipDeadEnd = [&]() -> int {
+        while (!deadEnds.empty()) {
+            const auto vertex = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[vertex] > 0) {
+                return static_cast<int>(vertex);
+            }
+        }
+        while (cursor < vertexCount) {
+            if (liveTriangles[cursor] > 0) {
+                return static_cast<int>(cursor);
+            }
+            ++cursor;
+        }
+        return -1;
+    };
+
+    auto fanning = skipDeadEnd();
+    clusters.push_back(0);
+    while (fanning >= 0) {
+        candidates.clear();
+        for (auto i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; ++i) {
+            const auto triangle = adjacency.triangles[i];
+            if (emitted[triangle]) {
+                continue;
+            }
+            for (auto corner = 0; corner < 3; ++corner) {
+                const auto vertex = indices[triangle * 3 + corner];
+                result.push_back(vertex);
+                deadEnds.push_back(vertex);
+                candidates.push_back(vertex);
+                --liveTriangles[vertex];
+                if (time - cacheTimes[vertex] > cacheSize) {
+                    cacheTimes[vertex] = time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        // The candidate that stays in the cache while its remaining triangles are emitted, the oldest such.
+        // When none would, the fan moves to a dead end.
+        auto next = -1;
+        auto bestPriority = 0u;
+        for (const auto vertex : candidates) {
+            if (liveTriangles[vertex] == 0) {
+                continue;
+            }
+            auto priority = 0u;
+            if (time - cacheTimes[vertex] + 2 * liveTriangles[vertex] <= cacheSize) {
+                priority = time - cacheTimes[vertex];
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                next = static_cast<int>(vertex);
+            }
+        }
+        if (next < 0) {
+            next = skipDeadEnd();
+            if (next >= 0) {
+                clusters.push_back(static_cast<unsigned int>(result.size() / 3));
+            }
+        }
+        fanning = next;
+    }
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeOverdraw(vector<unsigned int>& indices, const vector<Mesh::Vertex>& vertices,
+                                     const vector<unsigned int>& clusters, const float threshold, const unsigned int cacheSize)
+{
+    const auto triangleCount = static_cast<unsigned int>(indices.size() / 3);
+    if (triangleCount == 0 || clusters.empty()) {
+        return;
+    }
+    const auto vertexCount = static_cast<unsigned int>(vertices.size());
+
+    // Split the dead end clusters further wherever the cache has warmed up enough that starting cold again
+    // costs less than the threshold allows
+    vector<unsigned int> splits;
+    CacheSimulator cache(vertexCount, cacheSize);
+    for (auto c = 0u; c < clusters.size(); ++c) {
+        const auto begin = clusters[c];
+        const auto end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        cache.reset();
+        auto clusterMisses = 0u;
+        for (auto t = begin; t < end; ++t) {
+            clusterMisses += cache.add(&indices[t * 3]);
+        }
+        const auto clusterAcmr = static_cast<float>(clusterMisses) / (end - begin);
+
+        cache.reset();
+        splits.push_back(begin);
+        auto start = begin;
+        auto misses = 0u;
+        for (auto t = begin; t < end; ++t) {
+            misses += cache.add(&indices[t * 3]);
+            if (t + 1 < end && static_cast<float>(misses) <= clusterAcmr * threshold * (t + 1 - start)) {
+                splits.push_back(t + 1);
+                start = t + 1;
+                misses = 0;
+                cache.reset();
+            }
+        }
+    }
+
+    // Area weighted centroid and normal of every cluster and of the whole mesh
+    struct Cluster {
+        unsigned int begin;
+        unsigned int end;
+        float sortKey;
+    };
+    vector<Cluster> sorted;
+    vector<glm::vec3> centroids;
+    vector<glm::vec3> normals;
+    auto meshCentroid = glm::vec3(0.0f);
+    auto meshArea = 0.0f;
+    for (auto s = 0u; s < splits.size(); ++s) {
+        const auto begin = splits[s];
+        const auto end = s + 1 < splits.size() ? splits[s + 1] : triangleCount;
+        auto centroid = glm::vec3(0.0f);
+        auto normal = glm::vec3(0.0f);
+        auto area = 0.0f;
+        for (auto t = begin; t < end; ++t) {
+            const auto& a = vertices[indices[t * 3]].position;
+            const auto& b = vertices[indices[t * 3 + 1]].position;
+            const auto& c = vertices[indices[t * 3 + 2]].position;
+            const auto weightedNormal = glm::cross(b - a, c - a);
+            const auto triangleArea = glm::length(weightedNormal);
+            centroid += (a + b + c) * (triangleArea / 3.0f);
+            normal += weightedNormal;
+            area += triangleArea;
+        }
+        meshCentroid += centroid;
+        meshArea += area;
+        centroids.push_back(area > 0.0f ? centroid / area : centroid);
+        const auto normalLength = glm::length(normal);
+        normals.push_back(normalLength > 0.0f ? normal / normalLength : normal);
+        sorted.push_back(Cluster{ begin, end, 0.0f });
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+    for (auto s = 0u; s < sorted.size(); ++s) {
+        sorted[s].sortKey = glm::dot(centroids[s] - meshCentroid, normals[s]);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (const auto& cluster : sorted) {
+        result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    }
+    indices.swap(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(Mesh::CookedGeometry& cooked)
+{
+    const auto vertexCount = static_cast<unsigned int>(cooked.vertices.size());
+    const auto unused = vertexCount;
+    vector<unsigned int> remap(vertexCount, unused);
+    auto next = 0u;
+    for (auto& index : cooked.indices) {
+        if (remap[index] == unused) {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+    // Vertices no triangle uses are dropped
+    vector<Mesh::Vertex> vertices(next);
+    vector<Mesh::SkinVertex> skin(cooked.skin.empty() ? 0 : next);
+    for (auto i = 0u; i < vertexCount; ++i) {
+        if (remap[i] == unused) {
+            continue;
+        }
+        vertices[remap[i]] = cooked.vertices[i];
+        if (!skin.empty()) {
+            skin[remap[i]] = cooked.skin[i];
+        }
+    }
+    cooked.vertices.swap(vertices);
+    cooked.skin.swap(skin);
+}
+
+void MeshOptimizer::optimize(Mesh::CookedGeometry& cooked, const string& name)
+{
+    if (cooked.lods.empty()) {
+        cooked.lods.assign(1, Mesh::Lod{ 0, static_cast<unsigned int>(cooked.indices.size()), 0.0f, 0, 0 });
+    }
+    const auto vertexCount = static_cast<unsigned int>(cooked.vertices.size());
+    const auto fullBegin = cooked.indices.begin() + cooked.lods[0].indexOffset;
+    const auto before = analyzeVertexCache(vector<unsigned int>(fullBegin, fullBegin + cooked.lods[0].indexCount), vertexCount);
+
+    // Every level is drawn on its own, so triangles are reordered within each, the vertices for all of them
+    vector<unsigned int> levelIndices;
+    vector<unsigned int> clusters;
+    for (const auto& lod : cooked.lods) {
+        const auto begin = cooked.indices.begin() + lod.indexOffset;
+        levelIndices.assign(begin, begin + lod.indexCount);
+        optimizeVertexCache(levelIndices, vertexCount, clusters);
+        optimizeOverdraw(levelIndices, cooked.vertices, clusters);
+        std::copy(levelIndices.begin(), levelIndices.end(), begin);
+    }
+    optimizeVertexFetch(cooked);
+
+    const auto optimizedBegin = cooked.indices.begin() + cooked.lods[0].indexOffset;
+    const auto after = analyzeVertexCache(vector<unsigned int>(optimizedBegin, optimizedBegin + cooked.lods[0].indexCount),
+                                          static_cast<unsigned int>(cooked.vertices.size()));
+    string levels;
+    for (const auto& lod : cooked.lods) {
+        levels += (levels.empty() ? "" : "/") + std::to_string(lod.indexCount / 3);
+    }
+    printf("Mesh %s: %s triangles, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", name.c_str(), levels.c_str(),
+           before.acmr, after.acmr, before.atvr, after.atvr);
+}
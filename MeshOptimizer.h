@@ -0,0 +1,34 @@
+#pragma once
+#include "Mesh.h"
+#include "Constants.h"
+
+// Reorders a cooked mesh for the GPU before it is uploaded or packed. Triangles are first ordered for the post
+// transform vertex cache with Tipsify (Sander, Nehab, Barczak 2007), which fans around recently used vertices
+// and leaves clusters of triangles behind at every dead end. The clusters are then split wherever the cache
+// efficiency allows and sorted so the ones facing out from the mesh center draw first, which rejects more of
+// the rest at the depth test. Last the vertices are renumbered in order of first use so the fetches walk the
+// vertex buffers forward.
+class MeshOptimizer {
+public:
+    // Average transformed vertices per triangle (ACMR) and per vertex (ATVR) through a FIFO cache
+    struct CacheStats {
+        float acmr;
+        float atvr;
+    };
+
+    static CacheStats analyzeVertexCache(const vector<unsigned int>& indices, unsigned int vertexCount,
+                                         unsigned int cacheSize = constants::VERTEX_CACHE_SIZE);
+    // clusters receives the first triangle of every run that ended at a dead end
+    static void optimizeVertexCache(vector<unsigned int>& indices, unsigned int vertexCount, vector<unsigned int>& clusters,
+                                    unsigned int cacheSize = constants::VERTEX_CACHE_SIZE);
+    // threshold is the ACMR a cluster may lose relative to the cache optimized order, 1.05 allows 5%
+    static void optimizeOverdraw(vector<unsigned int>& indices, const vector<Mesh::Vertex>& vertices,
+                                 const vector<unsigned int>& clusters, float threshold = constants::OVERDRAW_THRESHOLD,
+                                 unsigned int cacheSize = constants::VERTEX_CACHE_SIZE);
+    // Renumbers vertices by first use, the skin stream follows along
+    static void optimizeVertexFetch(Mesh::CookedGeometry& cooked);
+
+    // All three in order, the first two on each level of detail, printing the cache statistics of the full level
+    // before and after
+    static void optimize(Mesh::CookedGeometry& cooked, const string& name);
+};
@@ -0,0 +1,325 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+namespace {
+    // Weighted sum of squared distances to a set of planes, symmetric 4x4 stored as its upper triangle, and the
+    // summed weight it is averaged by
+    struct Quadric {
+        double xx = 0, xy = 0, xz = 0, xw = 0, yy = 0, yz = 0, yw = 0, zz = 0, zw = 0, ww = 0;
+        double weight = 0;
+
+        void addPlane(const glm::vec3& normal, const double distance, const double weight)
+        {
+            const double x = normal.x, y = normal.y, z = normal.z, w = distance;
+            xx += weight * x * x;
+            xy += weight * x * y;
+            xz += weight * x * z;
+            xw += weight * x * w;
+            yy += weight * y * y;
+            yz += weight * y * z;
+            yw += weight * y * w;
+            zz += weight * z * z;
+            zw += weight * z * w;
+            ww += weight * w * w;
+            this->weight += weight;
+        }
+
+        void add(const Quadric& other)
+        {
+            xx += other.xx;
+            xy += other.xy;
+            xz += other.xz;
+            xw += other.xw;
+            yy += other.yy;
+            yz += other.yz;
+            yw += other.yw;
+            zz += other.zz;
+            zw += other.zw;
+            ww += other.ww;
+            weight += other.weight;
+        }
+
+        // Mean squared distance, a length squared however large the triangles are
+        double evaluate(const glm::vec3& point) const
+        {
+            if (weight <= 0.0) {
+                return 0.0;
+            }
+            const double x = point.x, y = point.y, z = point.z;
+            const auto error = xx * x * x + 2 * xy * x * y + 2 * xz * x * z + 2 * xw * x + yy * y * y + 2 * yz * y * z + 2 * yw * y
+                + zz * z * z + 2 * zw * z + ww;
+            return std::max(0.0, error / weight);
+        }
+    };
+
+    struct PositionHash {
+        size_t operator()(const glm::vec3& position) const
+        {
+            std::uint32_t bits[3];
+            std::memcpy(bits, &position[0], sizeof(bits));
+            return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+        }
+    };
+
+    struct PositionEqual {
+        bool operator()(const glm::vec3& a, const glm::vec3& b) const
+        {
+            return a.x == b.x && a.y == b.y && a.z == b.z;
+        }
+    };
+
+    struct Collapse {
+        unsigned int from;
+        unsigned int to;
+        double cost;
+    };
+
+    // How well vertex b can stand in for vertex a at a corner
+    float attributeMatch(const Mesh::Vertex& a, const Mesh::Vertex& b)
+    {
+        return glm::dot(a.normal, b.normal) - glm::length(a.texCoords - b.texCoords);
+    }
+}
+
+float MeshSimplifier::simplify(const vector<Mesh::Vertex>& vertices, const vector<unsigned int>& indices, const size_t targetIndexCount,
+                               const float maxError, vector<unsigned int>& result)
+{
+    result = indices;
+    const auto vertexCount = static_cast<unsigned int>(vertices.size());
+    if (indices.size() <= targetIndexCount || vertexCount == 0) {
+        return 0.0f;
+    }
+
+    // Every position is represented by the first vertex found there, the others are its copies
+    vector<unsigned int> representative(vertexCount);
+    std::unordered_map<glm::vec3, unsigned int, PositionHash, PositionEqual> firstAtPosition;
+    for (auto i = 0u; i < vertexCount; ++i) {
+        representative[i] = firstAtPosition.emplace(vertices[i].position, i).first->second;
+    }
+    vector<unsigned int> copyOffsets(vertexCount + 1, 0);
+    for (auto i = 0u; i < vertexCount; ++i) {
+        ++copyOffsets[representative[i] + 1];
+    }
+    for (auto i = 0u; i < vertexCount; ++i) {
+        copyOffsets[i + 1] += copyOffsets[i];
+    }
+    vector<unsigned int> copies(vertexCount);
+    {
+        vector<unsigned int> fill(copyOffsets.begin(), copyOffsets.end() - 1);
+        for (auto i = 0u; i < vertexCount; ++i) {
+            copies[fill[representative[i]]++] = i;
+        }
+    }
+
+    auto boundsMin = vertices[0].position;
+    auto boundsMax = vertices[0].position;
+    for (const auto& vertex : vertices) {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+    const auto diagonal = glm::length(boundsMax - boundsMin);
+    if (diagonal <= 0.0f) {
+        return 0.0f;
+    }
+    const auto errorLimit = static_cast<double>(maxError) * diagonal * maxError * diagonal;
+
+    // Area weighted planes of the triangles around each position
+    vector<Quadric> quadrics(vertexCount);
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        const auto& a = vertices[indices[t]].position;
+        const auto& b = vertices[indices[t + 1]].position;
+        const auto& c = vertices[indices[t + 2]].position;
+        const auto cross = glm::cross(b - a, c - a);
+        const auto length = glm::length(cross);
+        if (length <= 0.0f) {
+            continue;
+        }
+        const auto normal = cross / length;
+        const auto distance = -glm::dot(normal, a);
+        for (auto corner = 0; corner < 3; ++corner) {
+            quadrics[representative[indices[t + corner]]].addPlane(normal, distance, length * 0.5);
+        }
+    }
+
+    // Positions on an open or non manifold edge stay put
+    vector<bool> locked(vertexCount, false);
+    {
+        vector<std::uint64_t> edges;
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            for (auto corner = 0; corner < 3; ++corner) {
+                const auto a = representative[indices[t + corner]];
+                const auto b = representative[indices[t + (corner + 1) % 3]];
+                if (a != b) {
+                    edges.push_back(static_cast<std::uint64_t>(std::min(a, b)) << 32 | std::max(a, b));
+                }
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size();) {
+            auto end = i;
+            while (end < edges.size() && edges[end] == edges[i]) {
+                ++end;
+            }
+            if (end - i != 2) {
+                locked[edges[i] >> 32] = true;
+                locked[edges[i] & 0xffffffffu] = true;
+            }
+            i = end;
+        }
+    }
+
+    auto reachedError = 0.0;
+    vector<unsigned int> triangleOffsets(vertexCount + 1);
+    vector<unsigned int> triangles;
+    vector<Collapse> collapses;
+    vector<unsigned int> collapseTo(vertexCount);
+    vector<bool> touched(vertexCount);
+    while (result.size() > targetIndexCount) {
+        // Triangles around every position of the current mesh
+        std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+        for (const auto index : result) {
+            ++triangleOffsets[representative[index] + 1];
+        }
+        for (auto i = 0u; i < vertexCount; ++i) {
+            triangleOffsets[i + 1] += triangleOffsets[i];
+        }
+        triangles.resize(result.size());
+        {
+            vector<unsigned int> fill(triangleOffsets.begin(), triangleOffsets.end() - 1);
+            for (auto i = 0u; i < result.size(); ++i) {
+                triangles[fill[representative[result[i]]]++] = i / 3;
+            }
+        }
+
+        // Cheapest direction of every edge, each edge is seen from both of its triangles
+        collapses.clear();
+        for (size_t t = 0; t < result.size(); t += 3) {
+            for (auto corner = 0; corner < 3; ++corner) {
+                const auto a = representative[result[t + corner]];
+                const auto b = representative[result[t + (corner + 1) % 3]];
+                if (a >= b) {
+                    continue;
+                }
+                Quadric combined = quadrics[a];
+                combined.add(quadrics[b]);
+                if (!locked[a]) {
+                    collapses.push_back(Collapse{ a, b, combined.evaluate(vertices[b].position) });
+                }
+                if (!locked[b]) {
+                    const auto cost = combined.evaluate(vertices[a].position);
+                    if (locked[a] || cost < collapses.back().cost) {
+                        if (!locked[a]) {
+                            collapses.pop_back();
+                        }
+                        collapses.push_back(Collapse{ b, a, cost });
+                    }
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+            return a.cost < b.cost;
+        });
+
+        // As many as possible in one pass, each collapse freezes the neighbourhood it changed
+        for (auto i = 0u; i < vertexCount; ++i) {
+            collapseTo[i] = i;
+        }
+        std::fill(touched.begin(), touched.end(), false);
+        auto remainingIndices = result.size();
+        auto collapsed = false;
+        auto limitReached = false;
+        for (const auto& collapse : collapses) {
+            if (collapse.cost > errorLimit) {
+                limitReached = true;
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+            // Reject collapses that turn a triangle over or close to on edge, which leaves slivers behind
+            auto flips = false;
+            auto removed = 0u;
+            const auto& to = vertices[collapse.to].position;
+            for (auto i = triangleOffsets[collapse.from]; i < triangleOffsets[collapse.from + 1] && !flips; ++i) {
+                const auto t = triangles[i] * 3;
+                glm::vec3 corners[3];
+                auto movedCorner = 0;
+                auto sharesEdge = false;
+                for (auto corner = 0; corner < 3; ++corner) {
+                    const auto position = representative[result[t + corner]];
+                    corners[corner] = vertices[position].position;
+                    movedCorner = position == collapse.from ? corner : movedCorner;
+                    sharesEdge = sharesEdge || position == collapse.to;
+                }
+                if (sharesEdge) {
+                    ++removed;
+                    continue;
+                }
+                const auto before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                corners[movedCorner] = to;
+                const auto after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                flips = glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after);
+            }
+            if (flips) {
+                continue;
+            }
+
+            collapseTo[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            for (const auto center : { collapse.from, collapse.to }) {
+                for (auto i = triangleOffsets[center]; i < triangleOffsets[center + 1]; ++i) {
+                    for (auto corner = 0; corner < 3; ++corner) {
+                        touched[representative[result[triangles[i] * 3 + corner]]] = true;
+                    }
+                }
+            }
+            reachedError = std::max(reachedError, collapse.cost);
+            collapsed = true;
+            remainingIndices -= removed * 3;
+            if (remainingIndices <= targetIndexCount) {
+                break;
+            }
+        }
+        if (!collapsed) {
+            break;
+        }
+
+        // Moved corners take the copy at the new position that matches them best, collapsed triangles go
+        vector<unsigned int> next;
+        next.reserve(remainingIndices);
+        for (size_t t = 0; t < result.size(); t += 3) {
+            unsigned int triangle[3];
+            for (auto corner = 0; corner < 3; ++corner) {
+                const auto vertex = result[t + corner];
+                const auto target = collapseTo[representative[vertex]];
+                triangle[corner] = vertex;
+                if (target != representative[vertex]) {
+                    auto bestMatch = -1e30f;
+                    for (auto i = copyOffsets[target]; i < copyOffsets[target + 1]; ++i) {
+                        const auto match = attributeMatch(vertices[vertex], vertices[copies[i]]);
+                        if (match > bestMatch) {
+                            bestMatch = match;
+                            triangle[corner] = copies[i];
+                        }
+                    }
+                }
+            }
+            const auto a = representative[triangle[0]];
+            const auto b = representative[triangle[1]];
+            const auto c = representative[triangle[2]];
+            if (a != b && b != c && a != c) {
+                next.insert(next.end(), triangle, triangle + 3);
+            }
+        }
+        result.swap(next);
+        if (limitReached) {
+            break;
+        }
+    }
+    return static_cast<float>(std::sqrt(reachedError) / diagonal);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "Mesh.h"
+
+// Quadric error edge collapse (Garland, Heckbert 1997) on an index buffer. Vertices never move, an edge collapses
+// into one of its endpoints, so every level of detail indexes the vertex buffer of the full mesh. Work is done
+// on positions: vertices split by a normal or UV seam collapse together, each corner picking the copy whose
+// attributes match it best. Open borders are kept as they are, so neighbouring meshes don't crack apart.
+class MeshSimplifier {
+public:
+    // Collapses the cheapest edges until at most targetIndexCount indices are left or the next collapse would
+    // move the surface further than maxError, both relative to the mesh bounds diagonal. Returns the error
+    // reached, relative as well.
+    static float simplify(const vector<Mesh::Vertex>& vertices, const vector<unsigned int>& indices, size_t targetIndexCount,
+                          float maxError, vector<unsigned int>& result);
+};
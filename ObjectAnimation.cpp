@@ -1,14 +1,18 @@
 #include "ObjectAnimation.h"
 #include "GameObject.h"
 #include "Transform.h"
+#include "EngineClock.h"
+#include "Mesh.h"
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
 
 
-ObjectAnimation::ObjectAnimation(aiNodeAnim* animationData, const double duration, const double ticksPerSecond, const shared_ptr<GameObject>& parent, const bool startPlaying)
+ObjectAnimation::ObjectAnimation(const shared_ptr<const AnimationClip>& clip, const shared_ptr<GameObject>& parent, const bool startPlaying)
     : Component("object_animation", parent)
 {
-    this->duration = duration;
-    this->ticksPerSecond = ticksPerSecond > 0 ? ticksPerSecond : 25.0;
-    this->aiAnimationData = animationData;
+    this->clip = clip;
+    this->ticksPerSecond = clip->getTicksPerSecond();
+    this->duration = clip->getDuration() * ticksPerSecond;
 
     loop = true;
     currentAnimationTime = 0.0;
@@ -27,146 +31,125 @@ ComponentKey ObjectAnimation::getComponentKey()
 
 ObjectAnimation::~ObjectAnimation() = default;
 
-void ObjectAnimation::update()
+void ObjectAnimation::bind(const size_t channel, const shared_ptr<GameObject>& target)
 {
-    if (play && aiAnimationData) {
-        if (!started) {
-            timeStamp = clock();
-            started = true;
-        }
-        const auto elapsedMillis = double(clock() - timeStamp);
-        const auto elapsedSecs = elapsedMillis / CLOCKS_PER_SEC;
-        const auto currentTicks = elapsedSecs * ticksPerSecond;
-        const auto animLength = animationTimeEnd - animationTimeStart;
-        if (!loop && currentTicks >= animLength) {
-            started = false;
-            play = false;
-        } else {
-            currentAnimationTime = fmod(currentTicks, animLength) + animationTimeStart;
-
-            const auto currentRotation = calcInterpolatedRotation(currentAnimationTime);
-            const auto currentPosition = calcInterpolatedPosition(currentAnimationTime);
-            auto t = parent->getTransform();
-            t->setLocalRotation(currentRotation);
-            t->setLocalPosition(currentPosition);
+    Binding binding{ channel, target, target->getTransform(), {} };
+    auto objects = target->getGlobalChildrenList();
+    objects.push_front(target);
+    for (const auto& object : objects) {
+        for (const auto& mesh : object->getComponentList(MeshComponent)) {
+            binding.meshes.push_back(static_pointer_cast<Mesh>(mesh));
         }
     }
+    bindings.push_back(binding);
 }
 
-glm::quat ObjectAnimation::calcInterpolatedRotation(double animationTime) const
+unsigned int ObjectAnimation::getUpdateInterval(const Binding& binding) const
 {
-    // we need at least two values to interpolate...
-    if (aiAnimationData->mNumRotationKeys == 1) {
-        const auto aiQuat = aiAnimationData->mRotationKeys[0].mValue;
-        glm::quat retQuat;
-        retQuat.x = aiQuat.x;
-        retQuat.y = aiQuat.y;
-        retQuat.z = aiQuat.z;
-        retQuat.w = aiQuat.w;
-        return retQuat;
+    if (binding.meshes.empty()) {
+        // Nothing drawn to judge by, cameras, lights and the like
+        return 1;
     }
-
-    const auto rotationIndex = findRotation(animationTime);
-    if (rotationIndex >= 0) {
-        const auto nextRotationIndex = static_cast<unsigned>(rotationIndex + 1);
-        if (nextRotationIndex < aiAnimationData->mNumRotationKeys) {
-            const auto deltaTime = aiAnimationData->mRotationKeys[nextRotationIndex].mTime - aiAnimationData->mRotationKeys[rotationIndex].mTime;
-            if (deltaTime > 0) {
-                const auto factor = static_cast<float>((animationTime - aiAnimationData->mRotationKeys[rotationIndex].mTime) / deltaTime);
-                if (factor >= 0.0f && factor <= 1.0f) {
-                    const auto startRotationQ = aiAnimationData->mRotationKeys[rotationIndex].mValue;
-                    const auto endRotationQ = aiAnimationData->mRotationKeys[nextRotationIndex].mValue;
-                    aiQuaternion aiQuat;
-                    aiQuaternion::Interpolate(aiQuat, startRotationQ, endRotationQ, factor);
-                    aiQuat = aiQuat.Normalize();
-                    glm::quat retQuat;
-                    retQuat.x = aiQuat.x;
-                    retQuat.y = aiQuat.y;
-                    retQuat.z = aiQuat.z;
-                    retQuat.w = aiQuat.w;
-                    return retQuat;
-                }
-            }
-
-        }
-
+    auto screenSize = 0.0f;
+    for (const auto& mesh : binding.meshes) {
+        screenSize = std::max(screenSize, mesh->screenSize);
+    }
+    if (screenSize <= 0.0f) {
+        return gameplay ? constants::ANIMATION_LOD_FAR_INTERVAL : 0;
+    }
+    if (screenSize >= constants::ANIMATION_LOD_NEAR_SIZE) {
+        return 1;
     }
-    return parent->getTransform()->getRotation();
+    return screenSize >= constants::ANIMATION_LOD_FAR_SIZE ? constants::ANIMATION_LOD_MID_INTERVAL : constants::ANIMATION_LOD_FAR_INTERVAL;
 }
 
-glm::vec3 ObjectAnimation::calcInterpolatedScaling(double animationTime) const
+void ObjectAnimation::objectMounted()
 {
-    if (aiAnimationData->mNumScalingKeys == 1) {
-        const auto aiVec3d = aiAnimationData->mScalingKeys[0].mValue;
-        return glm::vec3(aiVec3d.x, aiVec3d.y, aiVec3d.z);
-    }
-    const auto scalingIndex = findScaling(animationTime);
-    const auto nextScalingIndex = (scalingIndex + 1);
-    assert(nextScalingIndex < aiAnimationData->mNumScalingKeys);
-    const auto deltaTime = static_cast<float>(aiAnimationData->mScalingKeys[nextScalingIndex].mTime - aiAnimationData->mScalingKeys[
-                                                  scalingIndex].mTime);
-    const auto factor = static_cast<float>(animationTime - aiAnimationData->mScalingKeys[scalingIndex].mTime) / deltaTime;
-    assert(factor >= 0.0f && factor <= 1.0f);
-    const auto start = aiAnimationData->mScalingKeys[scalingIndex].mValue;
-    const auto end = aiAnimationData->mScalingKeys[nextScalingIndex].mValue;
-    const auto delta = end - start;
-    const auto aiVec3d = start + factor * delta;
-    return glm::vec3(aiVec3d.x, aiVec3d.y, aiVec3d.z);
-}
-
-glm::vec3 ObjectAnimation::calcInterpolatedPosition(const double animationTime) const
-{
-    if (aiAnimationData->mNumPositionKeys == 1) {
-        const auto aiVec3d = aiAnimationData->mPositionKeys[0].mValue;
-        return glm::vec3(aiVec3d.x, aiVec3d.y, aiVec3d.z);
+    if (bindings.empty()) {
+        bindByName(parent);
     }
+}
 
-    const auto positionIndex = findPosition(animationTime);
-    const auto nextPositionIndex = (positionIndex + 1);
-    assert(nextPositionIndex < aiAnimationData->mNumPositionKeys);
-    const auto deltaTime = static_cast<float>(aiAnimationData->mPositionKeys[nextPositionIndex].mTime - aiAnimationData->mPositionKeys[
-                                                  positionIndex].mTime);
-    const auto factor = static_cast<float>(animationTime - aiAnimationData->mPositionKeys[positionIndex].mTime) / deltaTime;
-    assert(factor >= 0.0f && factor <= 1.0f);
-    const auto start = aiAnimationData->mPositionKeys[positionIndex].mValue;
-    const auto end = aiAnimationData->mPositionKeys[nextPositionIndex].mValue;
-    const auto delta = end - start;
-    const auto aiVec3d = start + factor * delta;
-    return glm::vec3(aiVec3d.x, aiVec3d.y, aiVec3d.z);
-}
-
-int ObjectAnimation::findRotation(const double animationTime) const
-{
-    if (aiAnimationData->mNumRotationKeys > 0) {
-        for (auto i = 0u; i < aiAnimationData->mNumRotationKeys - 1; i++) {
-            if (animationTime < aiAnimationData->mRotationKeys[i + 1].mTime) {
-                return i;
-            }
+void ObjectAnimation::bindByName(const shared_ptr<GameObject>& object)
+{
+    for (const auto& child : object->getChildren()) {
+        bindByName(child);
+    }
+    const auto name = object->getName();
+    for (auto i = 0u; i < clip->getChannelCount(); ++i) {
+        if (clip->getChannelName(i) == name && object->getTransform()) {
+            bind(i, object);
         }
     }
-    return -1;
 }
 
-unsigned int ObjectAnimation::findScaling(const double animationTime) const
+vector<shared_ptr<GameObject>> ObjectAnimation::getUpdateDependencies()
 {
-    for (unsigned int i = 0; i < aiAnimationData->mNumScalingKeys - 1; i++) {
-        if (animationTime < aiAnimationData->mScalingKeys[i + 1].mTime) {
-            return i;
-        }
+    vector<shared_ptr<GameObject>> objects;
+    for (const auto& binding : bindings) {
+        objects.push_back(binding.object);
     }
-
-    return 0;
+    return objects;
 }
 
-unsigned int ObjectAnimation::findPosition(const double animationTime) const
+void ObjectAnimation::update()
 {
-    for (unsigned int i = 0; i < aiAnimationData->mNumPositionKeys - 1; i++) {
-        if (animationTime > 0 && animationTime < aiAnimationData->mPositionKeys[i + 1].mTime) {
-            return i;
+    evaluatedChannels = 0;
+    if (play) {
+        const auto simulationTime = parent->engineClock->getSimulationTime();
+        if (!started) {
+            startTime = simulationTime;
+            started = true;
+        }
+        const auto elapsedSecs = simulationTime - startTime;
+        const auto currentTicks = elapsedSecs * ticksPerSecond;
+        const auto animLength = animationTimeEnd - animationTimeStart;
+        if (!loop && currentTicks >= animLength) {
+            started = false;
+            play = false;
+        } else {
+            currentAnimationTime = fmod(currentTicks, animLength) + animationTimeStart;
+
+            // Bindings on the same interval take turns, so throttled ones don't all land on the same step
+            ++updateCount;
+            dueBindings.clear();
+            dueChannels.clear();
+            for (auto i = 0u; i < bindings.size(); ++i) {
+                const auto interval = getUpdateInterval(bindings[i]);
+                if (interval > 0 && (updateCount + i) % interval == 0) {
+                    dueBindings.push_back(i);
+                    dueChannels.push_back(bindings[i].channel);
+                }
+            }
+            if (dueBindings.empty()) {
+                return;
+            }
+
+            const auto evaluated = clip->sample(static_cast<float>(currentAnimationTime / ticksPerSecond), dueChannels, dueGroups, pose);
+            evaluatedChannels = static_cast<unsigned int>(evaluated);
+            for (const auto index : dueBindings) {
+                const auto& binding = bindings[index];
+                const auto channel = binding.channel;
+                if (clip->animatesRotation(channel)) {
+                    binding.transform->setLocalRotation(glm::quat(pose.rotationW[channel], pose.rotationX[channel],
+                                                                  pose.rotationY[channel], pose.rotationZ[channel]));
+                }
+                if (clip->animatesPosition(channel)) {
+                    binding.transform->setLocalPosition(glm::vec3(pose.positionX[channel], pose.positionY[channel], pose.positionZ[channel]));
+                }
+            }
         }
     }
+}
+
+size_t ObjectAnimation::getBindingCount() const
+{
+    return bindings.size();
+}
 
-    return 0;
+unsigned int ObjectAnimation::getEvaluatedChannels() const
+{
+    return evaluatedChannels;
 }
 
 double ObjectAnimation::getCurrentAnimationTime() const
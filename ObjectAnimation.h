@@ -1,35 +1,58 @@
 #pragma once
 #include "Component.h"
-#include <ctime>
-#include <glm/gtc/quaternion.hpp>
-#include <assimp/anim.h>
+#include "AnimationClip.h"
 
+class Transform;
+class Mesh;
+
+// Plays a baked clip over a hierarchy. Every update samples the channels of the due bindings into a local pose
+// and writes it to the bound objects, children before their parents like the scene update visits them. Bound
+// objects are throttled by how large their meshes were on screen last frame: small ones are sampled every few
+// steps, culled ones not at all unless the animation matters to gameplay.
 class ObjectAnimation : public Component {
 public:
-    ObjectAnimation(aiNodeAnim* animationData, double duration, double ticksPerSecond, const shared_ptr<GameObject>& parent, bool startPlaying = true);
+    ObjectAnimation(const shared_ptr<const AnimationClip>& clip, const shared_ptr<GameObject>& parent, bool startPlaying = true);
     ComponentKey getComponentKey() override;
     ~ObjectAnimation();
-    double duration;
+    shared_ptr<const AnimationClip> clip;
+    double duration; // ticks
     double ticksPerSecond;
-    aiNodeAnim* aiAnimationData;
+    bool gameplay = false; // keeps animating off-screen, at the far rate. Loaders set it from the node metadata.
 
+    // Drives target with a channel of the clip, without explicit bindings the channels bind by name when mounted
+    void bind(size_t channel, const shared_ptr<GameObject>& target);
     void update() override;
+    vector<shared_ptr<GameObject>> getUpdateDependencies() override;
+    void objectMounted() override;
 
-    glm::quat calcInterpolatedRotation(double animationTime) const;
-    glm::vec3 calcInterpolatedScaling(double animationTime) const;
-    glm::vec3 calcInterpolatedPosition(double animationTime) const;
-    int findRotation(double animationTime) const;
-    unsigned int findScaling(double animationTime) const;
-    unsigned int findPosition(double animationTime) const;
     double getCurrentAnimationTime() const;
     bool isPlaying() const;
     void pauseAnimation();
     void playAnimation();
     void setLoop(bool loop);
     void setAnimationTime(float start, float end);
+    size_t getBindingCount() const;
+    unsigned int getEvaluatedChannels() const; // sampled by the last update, whole SIMD groups at a time
 private:
+    struct Binding {
+        size_t channel;
+        shared_ptr<GameObject> object;
+        shared_ptr<Transform> transform;
+        vector<shared_ptr<Mesh>> meshes; // drawn by the object or below it, their screen size sets the rate
+    };
+
+    void bindByName(const shared_ptr<GameObject>& object);
+    unsigned int getUpdateInterval(const Binding& binding) const; // in steps, 0 while paused
+
+    vector<Binding> bindings;
+    vector<size_t> dueBindings;
+    vector<size_t> dueChannels;
+    vector<std::uint8_t> dueGroups; // AnimationClip::sample's scratch
+    LocalPose pose;
+    unsigned int updateCount = 0;
+    unsigned int evaluatedChannels = 0;
     bool started = false;
-    clock_t timeStamp;
+    double startTime; // simulation time playback started at
     bool loop;
     double currentAnimationTime;
     bool play;
@@ -0,0 +1,247 @@
+#include "RenderGraph.h"
+#include "OpenGLImports.h"
+#include <algorithm>
+
+bool RenderTargetDesc::operator==(const RenderTargetDesc& other) const
+{
+    return width == other.width && height == other.height && layers == other.layers;
+}
+
+RenderGraph::~RenderGraph()
+{
+    for (const auto& target : pool) {
+        glDeleteFramebuffers(1, &target.frameBuffer);
+        glDeleteTextures(1, &target.colorTexture);
+        glDeleteTextures(1, &target.depthTexture);
+    }
+}
+
+void RenderGraph::reset()
+{
+    resources.clear();
+    passes.clear();
+    order.clear();
+}
+
+RenderResource RenderGraph::createTarget(const std::string& name, const RenderTargetDesc& desc)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resource.imported = false;
+    resource.output = false;
+    resource.frameBuffer = 0;
+    resources.push_back(resource);
+    return static_cast<RenderResource>(resources.size() - 1);
+}
+
+RenderResource RenderGraph::importResource(const std::string& name, const unsigned int frameBuffer, const bool output)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = RenderTargetDesc{ 0, 0, 0 };
+    resource.imported = true;
+    resource.output = output;
+    resource.frameBuffer = frameBuffer;
+    resources.push_back(resource);
+    return static_cast<RenderResource>(resources.size() - 1);
+}
+
+int RenderGraph::addPass(const std::string& name, const std::vector<RenderResource>& reads, const std::vector<RenderResource>& writes, const PassCallback& callback)
+{
+    const auto index = static_cast<int>(passes.size());
+    Pass pass;
+    pass.name = name;
+    pass.reads = reads;
+    pass.writes = writes;
+    pass.callback = callback;
+    for (const auto read : reads) {
+        auto& resource = resources[read];
+        if (resource.lastWriter >= 0) {
+            pass.inputs.push_back(resource.lastWriter);
+        }
+        resource.readersSinceWrite.push_back(index);
+    }
+    for (const auto write : writes) {
+        auto& resource = resources[write];
+        if (resource.lastWriter >= 0) {
+            pass.orderAfter.push_back(resource.lastWriter);
+        }
+        for (const auto reader : resource.readersSinceWrite) {
+            if (reader != index) {
+                pass.orderAfter.push_back(reader);
+            }
+        }
+        resource.readersSinceWrite.clear();
+        resource.lastWriter = index;
+    }
+    passes.push_back(pass);
+    return index;
+}
+
+void RenderGraph::markAlive(const int pass)
+{
+    if (passes[pass].alive) {
+        return;
+    }
+    passes[pass].alive = true;
+    for (const auto input : passes[pass].inputs) {
+        markAlive(input);
+    }
+}
+
+void RenderGraph::schedule(const int pass)
+{
+    if (passes[pass].scheduled || !passes[pass].alive) {
+        return;
+    }
+    passes[pass].scheduled = true;
+    // Dependencies go right before their first consumer, which keeps transient lifetimes short
+    for (const auto input : passes[pass].inputs) {
+        schedule(input);
+    }
+    for (const auto previous : passes[pass].orderAfter) {
+        schedule(previous);
+    }
+    order.push_back(pass);
+}
+
+void RenderGraph::compile()
+{
+    // Culling: only what ends up in an output is kept
+    std::vector<int> roots;
+    for (auto i = 0; i < static_cast<int>(passes.size()); ++i) {
+        for (const auto write : passes[i].writes) {
+            if (resources[write].output) {
+                roots.push_back(i);
+                markAlive(i);
+                break;
+            }
+        }
+    }
+    for (const auto root : roots) {
+        schedule(root);
+    }
+
+    // Lifetimes of the transient targets, in scheduled positions
+    std::vector<int> firstUse(resources.size(), -1);
+    std::vector<int> lastUse(resources.size(), -1);
+    for (auto position = 0; position < static_cast<int>(order.size()); ++position) {
+        const auto& pass = passes[order[position]];
+        const auto use = [&](const RenderResource resource) {
+            if (firstUse[resource] < 0) {
+                firstUse[resource] = position;
+            }
+            lastUse[resource] = position;
+        };
+        std::for_each(pass.reads.begin(), pass.reads.end(), use);
+        std::for_each(pass.writes.begin(), pass.writes.end(), use);
+    }
+
+    // Aliasing: a pooled target is free again once the last pass using its previous resource ran
+    for (auto& target : pool) {
+        target.busyUntil = -1;
+    }
+    for (auto position = 0; position < static_cast<int>(order.size()); ++position) {
+        for (auto resource = 0; resource < static_cast<int>(resources.size()); ++resource) {
+            if (!resources[resource].imported && firstUse[resource] == position) {
+                const auto target = acquirePhysicalTarget(resources[resource].desc, position);
+                pool[target].busyUntil = lastUse[resource];
+                resources[resource].physicalTarget = target;
+            }
+        }
+    }
+}
+
+int RenderGraph::acquirePhysicalTarget(const RenderTargetDesc& desc, const int firstUse)
+{
+    for (auto i = 0; i < static_cast<int>(pool.size()); ++i) {
+        if (pool[i].desc == desc && pool[i].busyUntil < firstUse) {
+            return i;
+        }
+    }
+
+    PhysicalTarget target;
+    target.desc = desc;
+    target.busyUntil = -1;
+    glGenFramebuffers(1, &target.frameBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.frameBuffer);
+    glGenTextures(1, &target.colorTexture);
+    glGenTextures(1, &target.depthTexture);
+    if (desc.layers > 1) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, target.colorTexture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB, desc.width, desc.height, desc.layers, 0, GL_BGR, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target.colorTexture, 0);
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, target.depthTexture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, desc.width, desc.height, desc.layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target.depthTexture, 0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, target.colorTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, desc.width, desc.height, 0, GL_BGR, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.colorTexture, 0);
+
+        glBindTexture(GL_TEXTURE_2D, target.depthTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, desc.width, desc.height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, target.depthTexture, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    GLenum drawBuffers[1] = { GL_COLOR_ATTACHMENT0 };
+    glDrawBuffers(1, drawBuffers);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    pool.push_back(target);
+    return static_cast<int>(pool.size() - 1);
+}
+
+void RenderGraph::execute() const
+{
+    for (const auto pass : order) {
+        passes[pass].callback(*this);
+    }
+}
+
+bool RenderGraph::isScheduled(const int pass) const
+{
+    return passes[pass].scheduled;
+}
+
+unsigned int RenderGraph::getFrameBuffer(const RenderResource resource) const
+{
+    const auto& entry = resources[resource];
+    if (entry.imported) {
+        return entry.frameBuffer;
+    }
+    return pool[entry.physicalTarget].frameBuffer;
+}
+
+int RenderGraph::bindTexture(const RenderResource resource, const int place) const
+{
+    const auto& entry = resources[resource];
+    if (entry.imported || entry.physicalTarget < 0) {
+        return -1;
+    }
+    const auto& target = pool[entry.physicalTarget];
+    glActiveTexture(GL_TEXTURE0 + place);
+    glBindTexture(target.desc.layers > 1 ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D, target.colorTexture);
+    return place;
+}
+
+size_t RenderGraph::getPhysicalTargetCount() const
+{
+    return pool.size();
+}
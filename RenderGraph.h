@@ -0,0 +1,80 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+// Index of a resource inside the frame being built
+using RenderResource = int;
+
+struct RenderTargetDesc {
+    int width;
+    int height;
+    int layers; // more than one makes a layered (2D array) target
+    bool operator==(const RenderTargetDesc& other) const;
+};
+
+// Frame graph: passes declare which resources they read and write, the graph drops the passes nothing
+// consumes, orders the rest producer-before-consumer and assigns transient targets to pooled framebuffers.
+// Transients whose lifetimes don't overlap share the same framebuffer, so memory follows the peak number of
+// targets alive at once instead of the number of passes. The pool survives between frames.
+class RenderGraph {
+public:
+    using PassCallback = std::function<void(const RenderGraph& graph)>;
+
+    RenderGraph() = default;
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+    ~RenderGraph();
+
+    void reset();
+    RenderResource createTarget(const std::string& name, const RenderTargetDesc& desc);
+    RenderResource importResource(const std::string& name, unsigned int frameBuffer = 0, bool output = false);
+    int addPass(const std::string& name, const std::vector<RenderResource>& reads, const std::vector<RenderResource>& writes, const PassCallback& callback);
+    void compile();
+    void execute() const;
+    bool isScheduled(int pass) const;
+
+    unsigned int getFrameBuffer(RenderResource resource) const;
+    int bindTexture(RenderResource resource, int place) const;
+    size_t getPhysicalTargetCount() const;
+
+private:
+    struct Resource {
+        std::string name;
+        RenderTargetDesc desc;
+        bool imported;
+        bool output;
+        unsigned int frameBuffer; // imported resources only
+        int physicalTarget = -1;
+        int lastWriter = -1;
+        std::vector<int> readersSinceWrite;
+    };
+
+    struct Pass {
+        std::string name;
+        std::vector<RenderResource> reads;
+        std::vector<RenderResource> writes;
+        PassCallback callback;
+        std::vector<int> inputs; // producers of what this pass reads, these keep it alive
+        std::vector<int> orderAfter; // write-after-write and write-after-read hazards, ordering only
+        bool alive = false;
+        bool scheduled = false;
+    };
+
+    struct PhysicalTarget {
+        RenderTargetDesc desc;
+        unsigned int frameBuffer;
+        unsigned int colorTexture;
+        unsigned int depthTexture;
+        int busyUntil;
+    };
+
+    void markAlive(int pass);
+    void schedule(int pass);
+    int acquirePhysicalTarget(const RenderTargetDesc& desc, int firstUse);
+
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<int> order;
+    std::vector<PhysicalTarget> pool;
+};
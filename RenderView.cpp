@@ -0,0 +1,240 @@
+#include "RenderView.h"
+#include "Mesh.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+
+namespace {
+    // Gribb, Hartmann: the six planes of a view projection matrix, normalized so they give distances
+    void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+    {
+        const auto row = [&viewProjection](const int i) {
+            return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        };
+        for (auto axis = 0; axis < 3; ++axis) {
+            planes[axis * 2] = row(3) + row(axis);
+            planes[axis * 2 + 1] = row(3) - row(axis);
+        }
+        for (auto i = 0; i < 6; ++i) {
+            planes[i] /= glm::length(glm::vec3(planes[i]));
+        }
+    }
+
+    bool sphereInside(const glm::vec4 planes[6], const glm::vec3& center, const float radius)
+    {
+        for (auto i = 0; i < 6; ++i) {
+            if (glm::dot(planes[i], glm::vec4(center, 1.0f)) < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+RenderView::RenderView(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position, const unsigned int target)
+{
+    this->view = view;
+    this->projection = projection;
+    this->viewProjection = projection * view;
+    this->position = position;
+    this->target = target;
+    extractFrustumPlanes(viewProjection, frustumPlanes);
+}
+
+RenderView RenderView::mirrored(const float planeHeight) const
+{
+    // The eye basis comes back out of the view matrix, so snapshots of the camera can be mirrored too
+    const auto eye = inverse(view);
+    const auto cameraFront = -glm::vec3(eye[2]);
+    const auto front = normalize(glm::vec3(cameraFront.x, cameraFront.y * -1.0f, cameraFront.z));
+    const auto right = normalize(cross(front, glm::vec3(0.0f, 1.0f, 0.0f)));
+    const auto up = normalize(cross(right, front));
+    auto mirroredPosition = position;
+    mirroredPosition.y -= 2 * (mirroredPosition.y - planeHeight);
+    return RenderView(glm::lookAt(mirroredPosition, mirroredPosition + front, up), projection, mirroredPosition, target);
+}
+
+RenderView RenderView::withClippingPlane(const glm::vec4& plane, const bool oblique) const
+{
+    auto result = *this;
+    result.clippingPlaneEnabled = true;
+    result.clippingPlane = plane;
+    // The oblique projection only works while the view is on the clipped side of the plane
+    result.obliqueClipping = oblique && dot(plane, glm::vec4(position, 1.0f)) < 0.0f;
+    if (result.obliqueClipping) {
+        // Oblique near plane (Lengyel): replaces the near plane with the clipping plane so no clip distance is needed
+        const auto viewPlane = transpose(inverse(view)) * plane;
+        auto& obliqueProjection = result.projection;
+        glm::vec4 q;
+        q.x = (glm::sign(viewPlane.x) + obliqueProjection[2][0]) / obliqueProjection[0][0];
+        q.y = (glm::sign(viewPlane.y) + obliqueProjection[2][1]) / obliqueProjection[1][1];
+        q.z = -1.0f;
+        q.w = (1.0f + obliqueProjection[2][2]) / obliqueProjection[3][2];
+        const auto c = viewPlane * (2.0f / dot(viewPlane, q));
+        obliqueProjection[0][2] = c.x;
+        obliqueProjection[1][2] = c.y;
+        obliqueProjection[2][2] = c.z + 1.0f;
+        obliqueProjection[3][2] = c.w;
+        result.viewProjection = obliqueProjection * view;
+        extractFrustumPlanes(result.viewProjection, result.frustumPlanes);
+    }
+    return result;
+}
+
+RenderView RenderView::withLayers(const RenderView& reflection, const RenderView& refraction) const
+{
+    auto result = *this;
+    result.multiView = true;
+    result.layerViews[constants::MULTI_VIEW_REFLECTION_LAYER] = reflection.view;
+    result.layerClippingPlanes[constants::MULTI_VIEW_REFLECTION_LAYER] = reflection.clippingPlane;
+    result.layerLodPasses[constants::MULTI_VIEW_REFLECTION_LAYER] = reflection.lodPass;
+    result.layerViews[constants::MULTI_VIEW_REFRACTION_LAYER] = refraction.view;
+    result.layerClippingPlanes[constants::MULTI_VIEW_REFRACTION_LAYER] = refraction.clippingPlane;
+    result.layerLodPasses[constants::MULTI_VIEW_REFRACTION_LAYER] = refraction.lodPass;
+    for (auto layer = 0; layer < constants::MULTI_VIEW_COUNT; ++layer) {
+        extractFrustumPlanes(result.getLayerViewProjectionMatrix(layer), result.layerFrustumPlanes[layer]);
+    }
+    return result;
+}
+
+RenderView RenderView::withoutLayer(const int layer) const
+{
+    auto result = *this;
+    result.layerClippingPlanes[layer] = glm::vec4(0.0f, 0.0f, 0.0f, -1.0f);
+    return result;
+}
+
+RenderView RenderView::withTarget(const unsigned int target) const
+{
+    auto result = *this;
+    result.target = target;
+    return result;
+}
+
+RenderView RenderView::withLodPass(const LodPass lodPass) const
+{
+    auto result = *this;
+    result.lodPass = lodPass;
+    return result;
+}
+
+glm::mat4 RenderView::getViewMatrix() const
+{
+    return view;
+}
+
+glm::mat4 RenderView::getProjectionMatrix() const
+{
+    return projection;
+}
+
+glm::mat4 RenderView::getViewProjectionMatrix() const
+{
+    return viewProjection;
+}
+
+glm::vec3 RenderView::getPosition() const
+{
+    return position;
+}
+
+unsigned int RenderView::getTarget() const
+{
+    return target;
+}
+
+LodPass RenderView::getLodPass() const
+{
+    return lodPass;
+}
+
+bool RenderView::hasClippingPlane() const
+{
+    return clippingPlaneEnabled;
+}
+
+glm::vec4 RenderView::getClippingPlane() const
+{
+    return clippingPlane;
+}
+
+bool RenderView::usesObliqueClipping() const
+{
+    return obliqueClipping;
+}
+
+bool RenderView::usesClipDistance() const
+{
+    return multiView || (clippingPlaneEnabled && !obliqueClipping);
+}
+
+bool RenderView::isMultiView() const
+{
+    return multiView;
+}
+
+glm::mat4 RenderView::getLayerViewMatrix(const int layer) const
+{
+    return layerViews[layer];
+}
+
+glm::mat4 RenderView::getLayerViewProjectionMatrix(const int layer) const
+{
+    return projection * layerViews[layer];
+}
+
+glm::vec4 RenderView::getLayerClippingPlane(const int layer) const
+{
+    return layerClippingPlanes[layer];
+}
+
+LodPass RenderView::getLayerLodPass(const int layer) const
+{
+    return layerLodPasses[layer];
+}
+
+bool RenderView::isVisible(const Mesh& mesh, const glm::mat4& model) const
+{
+    if (multiView) {
+        // Drawn once for all the layers, so keep it if any of them can see it
+        for (auto layer = 0; layer < constants::MULTI_VIEW_COUNT; ++layer) {
+            if (mesh.insideFrustum(getLayerViewProjectionMatrix(layer), model)
+                && !mesh.outsideClippingPlane(layerClippingPlanes[layer], model)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (!mesh.insideFrustum(viewProjection, model)) {
+        return false;
+    }
+    return !clippingPlaneEnabled || !mesh.outsideClippingPlane(clippingPlane, model);
+}
+
+bool RenderView::isVisible(const glm::vec3& center, const float radius) const
+{
+    const auto point = glm::vec4(center, 1.0f);
+    if (multiView) {
+        for (auto layer = 0; layer < constants::MULTI_VIEW_COUNT; ++layer) {
+            if (sphereInside(layerFrustumPlanes[layer], center, radius) && dot(layerClippingPlanes[layer], point) >= -radius) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (!sphereInside(frustumPlanes, center, radius)) {
+        return false;
+    }
+    return !clippingPlaneEnabled || dot(clippingPlane, point) >= -radius;
+}
+
+float RenderView::getScreenSize(const Mesh& mesh, const glm::mat4& model) const
+{
+    glm::vec3 worldMin, worldMax;
+    mesh.getWorldBounds(model, worldMin, worldMax);
+    const auto radius = glm::length(worldMax - worldMin) * 0.5f;
+    const auto distance = glm::length((worldMin + worldMax) * 0.5f - position);
+    if (distance <= radius) {
+        return 1.0f;
+    }
+    return std::min(1.0f, radius * projection[1][1] / distance);
+}
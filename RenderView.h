@@ -0,0 +1,73 @@
+#pragma once
+#include "Constants.h"
+#include <glm/glm.hpp>
+
+class Mesh;
+
+// Passes pick mesh levels of detail independently, each with its own tolerance and hysteresis state
+enum LodPass {
+    LodPassMain,
+    LodPassShadow,
+    LodPassReflection,
+    LodPassRefraction,
+    LodPassCount
+};
+
+// Everything a pass needs to draw the scene from one point of view: matrices, culling volume, clip plane and
+// the framebuffer it renders into. Views are built per pass and handed down the render calls, so passes never
+// modify the camera or the scene graph; "with" methods return adjusted copies.
+class RenderView {
+public:
+    RenderView(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position, unsigned int target = 0);
+
+    RenderView mirrored(float planeHeight) const;
+    RenderView withClippingPlane(const glm::vec4& plane, bool oblique) const;
+    RenderView withLayers(const RenderView& reflection, const RenderView& refraction) const;
+    // Clips everything from one layer of a multiview view, the others draw as before
+    RenderView withoutLayer(int layer) const;
+    RenderView withTarget(unsigned int target) const;
+    RenderView withLodPass(LodPass lodPass) const;
+
+    glm::mat4 getViewMatrix() const;
+    glm::mat4 getProjectionMatrix() const;
+    glm::mat4 getViewProjectionMatrix() const;
+    glm::vec3 getPosition() const;
+    unsigned int getTarget() const;
+    LodPass getLodPass() const;
+
+    bool hasClippingPlane() const;
+    glm::vec4 getClippingPlane() const;
+    bool usesObliqueClipping() const;
+    bool usesClipDistance() const;
+
+    bool isMultiView() const;
+    glm::mat4 getLayerViewMatrix(int layer) const;
+    glm::mat4 getLayerViewProjectionMatrix(int layer) const;
+    glm::vec4 getLayerClippingPlane(int layer) const;
+    LodPass getLayerLodPass(int layer) const;
+
+    bool isVisible(const Mesh& mesh, const glm::mat4& model) const;
+    // World space bounding sphere, for culling parts of a mesh
+    bool isVisible(const glm::vec3& center, float radius) const;
+    // Fraction of the screen height the bounds cover, up to 1
+    float getScreenSize(const Mesh& mesh, const glm::mat4& model) const;
+
+private:
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 frustumPlanes[6]; // of viewProjection, pointing inwards
+    glm::vec3 position;
+    unsigned int target;
+    LodPass lodPass = LodPassMain;
+
+    bool clippingPlaneEnabled = false;
+    bool obliqueClipping = false;
+    glm::vec4 clippingPlane;
+
+    bool multiView = false;
+    glm::mat4 layerViews[constants::MULTI_VIEW_COUNT];
+    glm::vec4 layerClippingPlanes[constants::MULTI_VIEW_COUNT];
+    LodPass layerLodPasses[constants::MULTI_VIEW_COUNT];
+    glm::vec4 layerFrustumPlanes[constants::MULTI_VIEW_COUNT][6];
+};
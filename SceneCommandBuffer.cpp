@@ -0,0 +1,170 @@
+#include "SceneCommandBuffer.h"
+#include "Transform.h"
+#include <cstdio>
+#include <unordered_map>
+#include <unordered_set>
+
+shared_ptr<GameObject> SceneCommandBuffer::createObject(const string& name, const shared_ptr<GameObject>& parent)
+{
+    auto object = make_shared<GameObject>(name, parent);
+    object->addComponent(make_shared<Transform>(object));
+    record(Command{ CreateCommand, object, parent, nullptr });
+    return object;
+}
+
+void SceneCommandBuffer::destroyObject(const shared_ptr<GameObject>& object)
+{
+    record(Command{ DestroyCommand, object, nullptr, nullptr });
+}
+
+void SceneCommandBuffer::reparentObject(const shared_ptr<GameObject>& object, const shared_ptr<GameObject>& parent)
+{
+    record(Command{ ReparentCommand, object, parent, nullptr });
+}
+
+void SceneCommandBuffer::addComponent(const shared_ptr<GameObject>& object, const shared_ptr<Component>& component)
+{
+    record(Command{ AddComponentCommand, object, nullptr, component });
+}
+
+void SceneCommandBuffer::record(const Command& command)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    commands.push_back(command);
+}
+
+bool SceneCommandBuffer::apply(const shared_ptr<GameObject>& scene)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (commands.empty()) {
+            return false;
+        }
+        applying.swap(commands);
+    }
+
+    // Only the last placement recorded for an object counts. A move under the object itself or one of its
+    // descendants, as the hierarchy stands with the batch's placements before it, is dropped.
+    std::unordered_set<const GameObject*> destroyed;
+    std::unordered_map<const GameObject*, size_t> placement;
+    const auto placedParent = [&](const GameObject* object) {
+        const auto found = placement.find(object);
+        return found != placement.end() ? applying[found->second].parent.get() : object->getParent().get();
+    };
+    for (auto i = 0u; i < applying.size(); ++i) {
+        const auto& command = applying[i];
+        if (command.type == DestroyCommand) {
+            destroyed.insert(command.object.get());
+        } else if (command.type == CreateCommand) {
+            placement[command.object.get()] = i;
+        } else if (command.type == ReparentCommand) {
+            auto ancestor = command.parent.get();
+            while (ancestor != nullptr && ancestor != command.object.get()) {
+                ancestor = placedParent(ancestor);
+            }
+            if (ancestor != nullptr) {
+                printf("Cannot move %s under %s, it would become its own ancestor\n", command.object->getName().c_str(),
+                       command.parent->getName().c_str());
+                continue;
+            }
+            placement[command.object.get()] = i;
+        }
+    }
+    const auto isPlaced = [&](const size_t i) {
+        const auto& command = applying[i];
+        const auto found = placement.find(command.object.get());
+        return (command.type == CreateCommand || command.type == ReparentCommand)
+            && !destroyed.count(command.object.get()) && found != placement.end() && found->second == i;
+    };
+
+    // Everything leaving a parent goes in one compaction of its children instead of an erase per object. An
+    // object whose moves were all dropped stays where it is.
+    std::unordered_map<GameObject*, std::unordered_set<const GameObject*>> detached;
+    for (auto i = 0u; i < applying.size(); ++i) {
+        const auto& command = applying[i];
+        if ((command.type == DestroyCommand || (command.type == ReparentCommand && isPlaced(i))) && command.object->getParent()) {
+            detached[command.object->getParent().get()].insert(command.object.get());
+        }
+    }
+    for (const auto& parent : detached) {
+        parent.first->removeChildren(parent.second);
+    }
+
+    // Room for all the new children of a parent is made once
+    std::unordered_map<GameObject*, size_t> attached;
+    for (auto i = 0u; i < applying.size(); ++i) {
+        if (isPlaced(i) && applying[i].parent) {
+            ++attached[applying[i].parent.get()];
+        }
+    }
+    for (const auto& parent : attached) {
+        parent.first->reserveChildren(parent.second);
+    }
+
+    std::vector<shared_ptr<GameObject>> mounted;
+    std::vector<shared_ptr<Component>> mountedComponents;
+    for (auto i = 0u; i < applying.size(); ++i) {
+        const auto& command = applying[i];
+        if (destroyed.count(command.object.get())) {
+            continue;
+        }
+        if (command.type == CreateCommand) {
+            mounted.push_back(command.object);
+        }
+        if (isPlaced(i)) {
+            command.object->setParent(command.parent);
+            if (command.parent) {
+                command.parent->addChild(command.object);
+            }
+            // Scene wide state follows the object into its new place
+            command.object->setIllumination(scene->illumination);
+            command.object->setCurrentCamera(scene->currentCamera);
+            command.object->setCommandBuffer(scene->commandBuffer);
+            command.object->setEngineClock(scene->engineClock);
+        } else if (command.type == AddComponentCommand) {
+            command.component->setParent(command.object);
+            command.object->addComponent(command.component);
+            mountedComponents.push_back(command.component);
+        }
+    }
+
+    // The components and children of a destroyed object point back at it, without this the subtree is never freed
+    for (const auto& command : applying) {
+        if (command.type == DestroyCommand) {
+            auto subtree = command.object->getGlobalChildrenList();
+            subtree.push_front(command.object);
+            for (const auto& object : subtree) {
+                object->clearComponents();
+                object->setParent(nullptr);
+            }
+        }
+    }
+
+    // Mounted once the whole batch is in, so they see each other. callObjectMounted covers the subtree, so
+    // whatever was created or given a component below another new object is mounted with it, once.
+    std::unordered_set<const GameObject*> mountedObjects;
+    for (const auto& object : mounted) {
+        mountedObjects.insert(object.get());
+    }
+    const auto isMountedWith = [&mountedObjects](shared_ptr<GameObject> object) {
+        for (; object; object = object->getParent()) {
+            if (mountedObjects.count(object.get())) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (const auto& object : mounted) {
+        if (!isMountedWith(object->getParent())) {
+            object->callObjectMounted();
+        }
+    }
+    for (const auto& component : mountedComponents) {
+        if (!isMountedWith(component->getParent())) {
+            component->objectMounted();
+        }
+    }
+
+    applying.clear();
+    return true;
+}
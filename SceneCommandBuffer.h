@@ -0,0 +1,44 @@
+#pragma once
+#include "GameObject.h"
+#include <mutex>
+#include <vector>
+
+// Structural changes requested while the scene is updating. GameObject::addChild, setParent and addComponent
+// edit vectors that other update jobs and the render thread are walking, so components record the change
+// here instead (any thread, the buffer is shared by the whole scene) and MainWindow applies everything at the
+// frame's sync point, when nothing else touches the scene.
+// Within a batch the last placement recorded for an object wins and destroying it wins over everything else;
+// children leaving or joining a parent are removed and reserved in bulk. Order between threads is undefined.
+// A move that would make an object its own ancestor is dropped with a message.
+class SceneCommandBuffer {
+public:
+    // The object is allocated right away so further commands can refer to it, it joins the scene on apply
+    shared_ptr<GameObject> createObject(const string& name, const shared_ptr<GameObject>& parent);
+    void destroyObject(const shared_ptr<GameObject>& object);
+    void reparentObject(const shared_ptr<GameObject>& object, const shared_ptr<GameObject>& parent);
+    void addComponent(const shared_ptr<GameObject>& object, const shared_ptr<Component>& component);
+
+    // Returns whether the hierarchy changed, cached views of it (draw lists, update plans) need rebuilding
+    bool apply(const shared_ptr<GameObject>& scene);
+
+private:
+    enum CommandType {
+        CreateCommand,
+        DestroyCommand,
+        ReparentCommand,
+        AddComponentCommand
+    };
+
+    struct Command {
+        CommandType type;
+        shared_ptr<GameObject> object;
+        shared_ptr<GameObject> parent;
+        shared_ptr<Component> component;
+    };
+
+    void record(const Command& command);
+
+    std::mutex mutex;
+    std::vector<Command> commands;
+    std::vector<Command> applying; // kept between frames so recording doesn't reallocate every frame
+};
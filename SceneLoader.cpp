@@ -1,6 +1,8 @@
 #include "SceneLoader.h"
+#include "AnimationClip.h"
 #include "Camera.h"
 #include "Constants.h"
+#include "Hlod.h"
 #include "Light.h"
 #include "MainCamera.h"
 #include "Material.h"
@@ -12,6 +14,7 @@
 #include "ShaderWater.h"
 #include "SkyBox.h"
 #include "Texture.h"
+#include "JobSystem.h"
 #include "Transform.h"
 #include "Water.h"
 #include <assimp/postprocess.h> // Post processing flags
@@ -25,6 +28,7 @@ SceneLoader::SceneLoader()
     auxShaders.push_back(waterShader);
     skyBoxShader = make_shared<ShaderMaterialSkyBox>(nullptr);
     auxShaders.push_back(skyBoxShader);
+    hlod = make_shared<Hlod>(nullptr);
 }
 
 
@@ -38,17 +42,84 @@ shared_ptr<GameObject> SceneLoader::loadScene(Assimp::Importer* importer,
                                               vector<shared_ptr<Camera>>& cameras,
                                               list<shared_ptr<Water>>& waterObjects)
 {
-    auxScene = importer->ReadFile(filePath,
-                                  aiProcess_CalcTangentSpace | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType);
-    if (auxScene == nullptr) {
-        printf(importer->GetErrorString());
+    const auto imported = importScene(importer, filePath);
+    if (imported == nullptr) {
         return nullptr;
     }
+    // Cooked node by node
+    return loadScene(imported, vector<Mesh::CookedGeometry>(), illumination, shaders, cameras, waterObjects);
+}
+
+shared_ptr<GameObject> SceneLoader::loadScene(const aiScene* scene,
+                                              const vector<Mesh::CookedGeometry>& cookedMeshes,
+                                              list<shared_ptr<Light>>& illumination,
+                                              vector<shared_ptr<Shader>>& shaders,
+                                              vector<shared_ptr<Camera>>& cameras,
+                                              list<shared_ptr<Water>>& waterObjects)
+{
+    auxScene = scene;
+    auxCookedMeshes = cookedMeshes.size() == scene->mNumMeshes && !cookedMeshes.empty() ? &cookedMeshes : nullptr;
 
     const auto rootNode = auxScene->mRootNode;
 
-    auto scene = loadScene(rootNode, nullptr); //Recursive load
+    auto root = loadScene(rootNode, nullptr); //Recursive load
+    hlod->build(materialDefaultShader);
+    auxCookedMeshes = nullptr;
+
+    collectLoaded(root, illumination, shaders, cameras, waterObjects);
+    return root;
+}
+
+void SceneLoader::cookMeshes(const aiScene& scene, JobSystem& jobs, vector<Mesh::CookedGeometry>& cookedMeshes)
+{
+    // Sized up front, the geometries point into their own arrays
+    cookedMeshes.clear();
+    cookedMeshes.resize(scene.mNumMeshes);
+    jobs.parallelFor(static_cast<int>(scene.mNumMeshes), [&scene, &cookedMeshes](const int i) {
+        Mesh::cook(scene.mMeshes[i], cookedMeshes[i]);
+    });
+}
+
+void SceneLoader::setTextureCache(TextureCache* cache)
+{
+    textureCache = cache != nullptr ? cache : &localTextures;
+}
+
+const aiScene* SceneLoader::importScene(Assimp::Importer* importer, const string& filePath)
+{
+    const auto scene = importer->ReadFile(filePath,
+                                          aiProcess_CalcTangentSpace | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices
+                                          | aiProcess_SortByPType | aiProcess_LimitBoneWeights);
+    if (scene == nullptr) {
+        printf(importer->GetErrorString());
+    }
+    return scene;
+}
 
+WaterModes SceneLoader::readWaterModes(const aiNode& node)
+{
+    WaterModes modes;
+    if (node.mMetaData != nullptr) {
+        node.mMetaData->Get("obliqueClipping", modes.obliqueClipping);
+        node.mMetaData->Get("multiView", modes.multiView);
+        auto screenSpace = false;
+        if (node.mMetaData->Get("screenSpaceRefraction", screenSpace) && screenSpace) {
+            modes.refractionMode = ScreenSpaceRefraction;
+        }
+        screenSpace = false;
+        if (node.mMetaData->Get("screenSpaceReflection", screenSpace) && screenSpace) {
+            modes.reflectionMode = ScreenSpaceReflection;
+        }
+    }
+    return modes;
+}
+
+void SceneLoader::collectLoaded(const shared_ptr<GameObject>& scene,
+                                list<shared_ptr<Light>>& illumination,
+                                vector<shared_ptr<Shader>>& shaders,
+                                vector<shared_ptr<Camera>>& cameras,
+                                list<shared_ptr<Water>>& waterObjects)
+{
     for (const auto& shader : auxShaders) {
         if (shader->getParent() == nullptr) {
             shader->setParent(scene);
@@ -68,7 +139,6 @@ shared_ptr<GameObject> SceneLoader::loadScene(Assimp::Importer* importer,
         waterObjects.push_back(water);
     }
     auxWaterObjects.clear();
-    return scene;
 }
 
 shared_ptr<GameObject> SceneLoader::loadScene(aiNode* node, const shared_ptr<GameObject>& parent)
@@ -93,23 +163,18 @@ shared_ptr<GameObject> SceneLoader::loadScene(aiNode* node, const shared_ptr<Gam
         if (node->mNumMeshes > 0) {
             genericNode = false;
             auto doNotRender = false;
-            // WATER OBJECT
-            if (node->mName == aiString("WATER")) {
-                auto water = make_shared<Water>(node->mName.C_Str(), parent);
-                water->addComponent(waterShader);
-                res = water;
-                waterShader->setParent(res);
-                auxWaterObjects.push_back(water);
-                doNotRender = true;
-            } else {
-                res = make_shared<GameObject>(node->mName.C_Str(), parent);
-                res->addComponent(materialDefaultShader);
-            }
+            res = createMeshObject(node->mName.C_Str(), parent, readWaterModes(*node), doNotRender);
 
             for (auto i = 0u; i < node->mNumMeshes; ++i) {
                 auto mesh = auxScene->mMeshes[node->mMeshes[i]];
-                auto meshComponent = make_shared<Mesh>(mesh, res);
+                Mesh::CookedGeometry cooked;
+                if (auxCookedMeshes == nullptr) {
+                    Mesh::cook(mesh, cooked);
+                }
+                const auto& geometry = auxCookedMeshes != nullptr ? (*auxCookedMeshes)[node->mMeshes[i]].geometry : cooked.geometry;
+                auto meshComponent = make_shared<Mesh>(geometry, res);
                 res->addComponent(meshComponent);
+                hlod->addSource(meshComponent, geometry);
                 if (!materialDefaultShader->material) {
                     // yes, we have only one material for all the scene
                     auto mat = loadMaterial(mesh, res);
@@ -125,39 +190,18 @@ shared_ptr<GameObject> SceneLoader::loadScene(aiNode* node, const shared_ptr<Gam
         if (genericNode && (parent != nullptr)) {
             res = make_shared<GameObject>(node->mName.C_Str(), parent);
         } else if (parent == nullptr) {
-            // Root Node
-            res = make_shared<RootSceneObject>(node->mName.C_Str(), auxScene);
-
-            // Root Node generates the Skybox
-            vector<string> skyboxFaces{
-                "skybox/cloudtop_rt.tga",
-                "skybox/cloudtop_lf.tga",
-                "skybox/cloudtop_up.tga",
-                "skybox/cloudtop_dn.tga",
-                "skybox/cloudtop_bk.tga",
-                "skybox/cloudtop_ft.tga"
-            };
-            const auto skyBox = make_shared<SkyBox>(skyboxFaces, res);
-            res->addComponent(skyBoxShader);
-            res->addComponent(skyBox);
-        }
+            res = createRoot(node->mName.C_Str());
 
-        if (res != nullptr) {
-            // Animation loading
+            // Animations are baked once and played from the root, the channels find their nodes when mounted
             for (auto i = 0u; i < auxScene->mNumAnimations; ++i) {
-                auto anim = auxScene->mAnimations[i];
-                for (auto j = 0u; j < anim->mNumChannels; ++j) {
-                    auto channel = anim->mChannels[j];
-                    if (channel->mNodeName == node->mName) {
-                        auto compAnim = make_shared<ObjectAnimation>(channel, anim->mDuration, anim->mTicksPerSecond, res);
-                        res->addComponent(compAnim);
-                        // compAnim->pauseAnimation();
-                    }
-                }
+                const auto clip = make_shared<AnimationClip>(*auxScene->mAnimations[i]);
+                const auto animation = make_shared<ObjectAnimation>(clip, res);
+                animation->gameplay = AnimationClip::isGameplay(*auxScene, *auxScene->mAnimations[i]);
+                res->addComponent(animation);
             }
+        }
 
-            // *****************
-
+        if (res != nullptr) {
             for (auto i = 0u; i < node->mNumChildren; ++i) {
                 auto child = loadScene(node->mChildren[i], res);
                 if (child != nullptr) {
@@ -169,29 +213,203 @@ shared_ptr<GameObject> SceneLoader::loadScene(aiNode* node, const shared_ptr<Gam
             aiQuaternion rotation;
             aiVector3D scale;
             node->mTransformation.Decompose(scale, rotation, position);
-            auto transform = res->getTransform();
-            if (!transform) {
-                transform = std::make_shared<Transform>(res);
-                res->addComponent(transform);
-            }
-            transform->setPosition(position.x, position.y, position.z);
-            transform->setScale(scale.x, scale.y, scale.z);
-            transform->setRotation(rotation.x, rotation.y, rotation.z, rotation.w);
-            auto camera = static_pointer_cast<Camera>(res->getComponentFirst(CameraComponent));
-            if (camera != nullptr) {
-                auto front = (transform->getRotation() * glm::vec3(0.0f, 1.0f, 0.0f)) - transform->getPosition();
-                auto right = normalize(cross(front, glm::vec3(0.0f, 1.0f, 0.0f)));
-                auto up = normalize(cross(right, front));
-                camera->setCameraFront(front.x, front.y, front.z);
-                camera->setCameraRight(right.x, right.y, right.z);
-                camera->setCameraUp(up.x, up.y, up.z);
-            }
+            placeObject(res, position, rotation, scale);
             return res;
         }
     }
     return nullptr;
 }
 
+shared_ptr<GameObject> SceneLoader::loadScenePack(const ScenePack& pack,
+                                                  list<shared_ptr<Light>>& illumination,
+                                                  vector<shared_ptr<Shader>>& shaders,
+                                                  vector<shared_ptr<Camera>>& cameras,
+                                                  list<shared_ptr<Water>>& waterObjects)
+{
+    auxScene = nullptr;
+    size_t node = 0;
+    auto scene = loadPackNode(pack, node, nullptr);
+    hlod->build(materialDefaultShader);
+
+    collectLoaded(scene, illumination, shaders, cameras, waterObjects);
+    return scene;
+}
+
+shared_ptr<GameObject> SceneLoader::loadPackNode(const ScenePack& pack, size_t& node, const shared_ptr<GameObject>& parent)
+{
+    const auto& record = pack.getNodes()[node++];
+    const auto name = pack.getString(record.name);
+    shared_ptr<GameObject> res = nullptr;
+    auto genericNode = true;
+    if (record.light >= 0) {
+        genericNode = false;
+
+        const auto& lightRecord = pack.getLights()[record.light];
+        aiLight light;
+        light.mName.Set(pack.getString(lightRecord.name));
+        light.mType = static_cast<aiLightSourceType>(lightRecord.type);
+        light.mColorDiffuse = aiColor3D(lightRecord.diffuse[0], lightRecord.diffuse[1], lightRecord.diffuse[2]);
+        light.mColorAmbient = aiColor3D(lightRecord.ambient[0], lightRecord.ambient[1], lightRecord.ambient[2]);
+        light.mColorSpecular = aiColor3D(lightRecord.specular[0], lightRecord.specular[1], lightRecord.specular[2]);
+        light.mAttenuationConstant = lightRecord.attenuation[0];
+        light.mAttenuationLinear = lightRecord.attenuation[1];
+        light.mAttenuationQuadratic = lightRecord.attenuation[2];
+        light.mAngleInnerCone = lightRecord.innerAngle;
+        light.mAngleOuterCone = lightRecord.outerAngle;
+        res = loadLight(&light, parent);
+        auxIllumination.push_back(static_pointer_cast<Light>(res->getComponentFirst(LightComponent)));
+    }
+    if (record.camera >= 0) {
+        genericNode = false;
+
+        const auto& cameraRecord = pack.getCameras()[record.camera];
+        aiCamera camera;
+        camera.mName.Set(pack.getString(cameraRecord.name));
+        camera.mPosition = aiVector3D(cameraRecord.position[0], cameraRecord.position[1], cameraRecord.position[2]);
+        res = loadCamera(&camera, parent);
+        auxCameras.push_back(static_pointer_cast<Camera>(res->getComponentFirst(CameraComponent)));
+    }
+    const auto meshCount = static_cast<size_t>(record.meshes.size / sizeof(std::uint32_t));
+    if (meshCount > 0) {
+        genericNode = false;
+        auto doNotRender = false;
+        res = createMeshObject(name, parent, record.water, doNotRender);
+
+        const auto meshIndices = static_cast<const std::uint32_t*>(pack.getData(record.meshes));
+        for (size_t i = 0; i < meshCount; ++i) {
+            const auto& meshRecord = pack.getMeshes()[meshIndices[i]];
+            // The arrays go to GL straight from the mapping
+            Mesh::Geometry geometry;
+            // Compressed at cook time when COMPACT_VERTEX_FORMAT was on, upload reads whichever is there
+            if (meshRecord.compactPositions.size > 0) {
+                geometry.compactPositions = static_cast<const Mesh::CompactPosition*>(pack.getData(meshRecord.compactPositions));
+                geometry.compactAttributes = static_cast<const Mesh::CompactAttributes*>(pack.getData(meshRecord.compactAttributes));
+            } else {
+                geometry.vertices = static_cast<const Mesh::Vertex*>(pack.getData(meshRecord.vertices));
+            }
+            geometry.vertexCount = meshRecord.vertexCount;
+            if (meshRecord.shortIndices.size > 0) {
+                geometry.shortIndices = static_cast<const std::uint16_t*>(pack.getData(meshRecord.shortIndices));
+            } else {
+                geometry.indices = static_cast<const unsigned int*>(pack.getData(meshRecord.indices));
+            }
+            geometry.indexCount = meshRecord.indexCount;
+            geometry.positionOffset = glm::vec3(meshRecord.positionOffset[0], meshRecord.positionOffset[1], meshRecord.positionOffset[2]);
+            geometry.positionScale = glm::vec3(meshRecord.positionScale[0], meshRecord.positionScale[1], meshRecord.positionScale[2]);
+            geometry.lods = static_cast<const Mesh::Lod*>(pack.getData(meshRecord.lods));
+            geometry.lodCount = static_cast<unsigned int>(meshRecord.lods.size / sizeof(Mesh::Lod));
+            geometry.clusters = static_cast<const Mesh::Cluster*>(pack.getData(meshRecord.clusters));
+            geometry.clusterCount = static_cast<unsigned int>(meshRecord.clusters.size / sizeof(Mesh::Cluster));
+            geometry.closed = meshRecord.closed != 0;
+            geometry.skin = meshRecord.skin.size > 0 ? static_cast<const Mesh::SkinVertex*>(pack.getData(meshRecord.skin)) : nullptr;
+            geometry.minPoints = glm::vec3(meshRecord.minPoints[0], meshRecord.minPoints[1], meshRecord.minPoints[2]);
+            geometry.maxPoints = glm::vec3(meshRecord.maxPoints[0], meshRecord.maxPoints[1], meshRecord.maxPoints[2]);
+            geometry.boneNames = pack.getStrings(meshRecord.boneNames);
+            const auto boneOffsets = static_cast<const glm::mat4*>(pack.getData(meshRecord.boneOffsets));
+            geometry.boneOffsets.assign(boneOffsets, boneOffsets + meshRecord.boneCount);
+
+            auto meshComponent = make_shared<Mesh>(geometry, res);
+            res->addComponent(meshComponent);
+            hlod->addSource(meshComponent, geometry);
+            if (!materialDefaultShader->material) {
+                // yes, we have only one material for all the scene
+                auto mat = loadPackMaterial(pack, pack.getMaterials()[meshRecord.material], res);
+                meshComponent->material = mat;
+                materialDefaultShader->material = mat;
+            }
+            meshComponent->doNotRender = doNotRender;
+        }
+    }
+
+    if (genericNode && (parent != nullptr)) {
+        res = make_shared<GameObject>(name, parent);
+    } else if (parent == nullptr) {
+        res = createRoot(name);
+
+        for (const auto& animation : pack.getAnimations()) {
+            const auto component = make_shared<ObjectAnimation>(pack.loadAnimation(animation), res);
+            component->gameplay = animation.gameplay != 0;
+            res->addComponent(component);
+        }
+    }
+
+    for (auto i = 0u; i < record.childCount; ++i) {
+        auto child = loadPackNode(pack, node, res);
+        if (child != nullptr) {
+            res->addChild(child);
+        }
+    }
+
+    placeObject(res,
+                aiVector3D(record.position[0], record.position[1], record.position[2]),
+                aiQuaternion(record.rotation[3], record.rotation[0], record.rotation[1], record.rotation[2]),
+                aiVector3D(record.scale[0], record.scale[1], record.scale[2]));
+    return res;
+}
+
+shared_ptr<GameObject> SceneLoader::createMeshObject(const string& name, const shared_ptr<GameObject>& parent,
+                                                     const WaterModes& waterModes, bool& doNotRender)
+{
+    // WATER OBJECT
+    if (name == "WATER") {
+        auto water = make_shared<Water>(name, parent);
+        water->modes = waterModes;
+        water->addComponent(waterShader);
+        waterShader->setParent(water);
+        auxWaterObjects.push_back(water);
+        doNotRender = true;
+        return water;
+    }
+    auto res = make_shared<GameObject>(name, parent);
+    res->addComponent(materialDefaultShader);
+    return res;
+}
+
+shared_ptr<GameObject> SceneLoader::createRoot(const string& name)
+{
+    // Root Node
+    auto res = make_shared<RootSceneObject>(name, auxScene);
+
+    // Root Node generates the Skybox
+    vector<string> skyboxFaces{
+        "skybox/cloudtop_rt.tga",
+        "skybox/cloudtop_lf.tga",
+        "skybox/cloudtop_up.tga",
+        "skybox/cloudtop_dn.tga",
+        "skybox/cloudtop_bk.tga",
+        "skybox/cloudtop_ft.tga"
+    };
+    const auto skyBox = make_shared<SkyBox>(textureCache->loadCubeMap(skyboxFaces), res);
+    res->addComponent(skyBoxShader);
+    res->addComponent(skyBox);
+    // and groups far meshes into proxies once they are all placed
+    hlod->setParent(res);
+    res->addComponent(hlod);
+    return res;
+}
+
+void SceneLoader::placeObject(const shared_ptr<GameObject>& object, const aiVector3D& position, const aiQuaternion& rotation,
+                              const aiVector3D& scale)
+{
+    auto transform = object->getTransform();
+    if (!transform) {
+        transform = std::make_shared<Transform>(object);
+        object->addComponent(transform);
+    }
+    transform->setPosition(position.x, position.y, position.z);
+    transform->setScale(scale.x, scale.y, scale.z);
+    transform->setRotation(rotation.x, rotation.y, rotation.z, rotation.w);
+    auto camera = static_pointer_cast<Camera>(object->getComponentFirst(CameraComponent));
+    if (camera != nullptr) {
+        auto front = (transform->getRotation() * glm::vec3(0.0f, 1.0f, 0.0f)) - transform->getPosition();
+        auto right = normalize(cross(front, glm::vec3(0.0f, 1.0f, 0.0f)));
+        auto up = normalize(cross(right, front));
+        camera->setCameraFront(front.x, front.y, front.z);
+        camera->setCameraRight(right.x, right.y, right.z);
+        camera->setCameraUp(up.x, up.y, up.z);
+    }
+}
+
 shared_ptr<GameObject> SceneLoader::loadLight(aiLight* lightNode, const shared_ptr<GameObject>& parent) const
 {
     const auto lType = lightNode->mType;
@@ -289,7 +507,30 @@ shared_ptr<Material> SceneLoader::loadMaterial(aiMesh* meshNode, const shared_pt
     aiString texturePath;
     const auto numTextures = associatedMaterial->GetTextureCount(aiTextureType_DIFFUSE);
     if (numTextures > 0 && associatedMaterial->GetTexture(aiTextureType_DIFFUSE, 0, &texturePath) == AI_SUCCESS) {
-        material->diffuseMap = make_unique<Texture>(texturePath.C_Str());
+        material->diffuseMap = textureCache->load(texturePath.C_Str());
+    }
+
+    parent->addComponent(material);
+    return material;
+}
+
+shared_ptr<Material> SceneLoader::loadPackMaterial(const ScenePack& pack, const ScenePack::MaterialRecord& record,
+                                                   const shared_ptr<GameObject>& parent) const
+{
+    auto material = std::make_shared<Material>(parent);
+    material->ambient = glm::vec4(record.ambient[0], record.ambient[1], record.ambient[2], record.ambient[3]);
+    material->diffuse = glm::vec4(record.diffuse[0], record.diffuse[1], record.diffuse[2], record.diffuse[3]);
+    material->specular = glm::vec4(record.specular[0], record.specular[1], record.specular[2], record.specular[3]);
+    material->emission = glm::vec4(record.emission[0], record.emission[1], record.emission[2], record.emission[3]);
+    material->shininess = record.shininess;
+
+    // Diffuse Map, decoded from the copy in the pack when the cooker could read the file
+    if (record.diffuseMap.size > 0) {
+        // Keyed by the path it was read from, the same image as a material loading that file
+        material->diffuseMap = textureCache->load(pack.getString(record.diffuseMapPath), pack.getData(record.diffuseMap),
+                                                  static_cast<size_t>(record.diffuseMap.size));
+    } else if (record.diffuseMapPath.size > 0) {
+        material->diffuseMap = textureCache->load(pack.getString(record.diffuseMapPath));
     }
 
     parent->addComponent(material);
@@ -8,6 +8,9 @@
 #include <vector>
 #include <list>
 #include <memory>
+#include "ScenePack.h"
+#include "Mesh.h"
+#include "TextureCache.h"
 
 class GameObject;
 class Shader;
@@ -15,8 +18,9 @@ class ShaderMaterialDefault;
 class Light;
 class Camera;
 class Material;
-class Mesh;
+class JobSystem;
 class Water;
+class Hlod;
 
 using namespace std;
 
@@ -30,12 +34,46 @@ public:
                                      vector<shared_ptr<Shader>>& shaders,
                                      vector<shared_ptr<Camera>>& cameras,
                                      list<shared_ptr<Water>>& waterObjects);
+    // From a scene imported ahead, cookedMeshes holding Mesh::cook of every one of its meshes in order
+    shared_ptr<GameObject> loadScene(const aiScene* scene,
+                                     const vector<Mesh::CookedGeometry>& cookedMeshes,
+                                     list<shared_ptr<Light>>& illumination,
+                                     vector<shared_ptr<Shader>>& shaders,
+                                     vector<shared_ptr<Camera>>& cameras,
+                                     list<shared_ptr<Water>>& waterObjects);
     shared_ptr<GameObject> loadScene(aiNode* node, const shared_ptr<GameObject>& parent);
+    // Same scene as loadScene builds, from a pack cooked out of it
+    shared_ptr<GameObject> loadScenePack(const ScenePack& pack,
+                                         list<shared_ptr<Light>>& illumination,
+                                         vector<shared_ptr<Shader>>& shaders,
+                                         vector<shared_ptr<Camera>>& cameras,
+                                         list<shared_ptr<Water>>& waterObjects);
+    static const aiScene* importScene(Assimp::Importer* importer, const string& filePath);
+    // The water modes a node asks for in its metadata, the defaults for the keys it leaves out
+    static WaterModes readWaterModes(const aiNode& node);
+    // The meshes are independent, so they cook on the pool; needs no GL context
+    static void cookMeshes(const aiScene& scene, JobSystem& jobs, vector<Mesh::CookedGeometry>& cookedMeshes);
+    // Where the textures come from, shared with whatever else loads from the same cache. Without one the
+    // loader keeps a cache of its own, which still loads an image once per scene.
+    void setTextureCache(TextureCache* cache);
     shared_ptr<GameObject> loadLight(aiLight* lightNode, const shared_ptr<GameObject>& parent) const;
     static shared_ptr<GameObject> loadCamera(aiCamera* cameraNode, const shared_ptr<GameObject>& parent);
     shared_ptr<Material> loadMaterial(aiMesh* meshNode, const shared_ptr<GameObject>& parent) const;
 
 private:
+    shared_ptr<GameObject> loadPackNode(const ScenePack& pack, size_t& node, const shared_ptr<GameObject>& parent);
+    shared_ptr<Material> loadPackMaterial(const ScenePack& pack, const ScenePack::MaterialRecord& record,
+                                          const shared_ptr<GameObject>& parent) const;
+    shared_ptr<GameObject> createMeshObject(const string& name, const shared_ptr<GameObject>& parent, const WaterModes& waterModes,
+                                            bool& doNotRender);
+    shared_ptr<GameObject> createRoot(const string& name);
+    void collectLoaded(const shared_ptr<GameObject>& scene,
+                       list<shared_ptr<Light>>& illumination,
+                       vector<shared_ptr<Shader>>& shaders,
+                       vector<shared_ptr<Camera>>& cameras,
+                       list<shared_ptr<Water>>& waterObjects);
+    static void placeObject(const shared_ptr<GameObject>& object, const aiVector3D& position, const aiQuaternion& rotation,
+                            const aiVector3D& scale);
 
     aiLight* getLightAssociated(aiNode* node) const;
     aiCamera* getCameraAssociated(aiNode* node) const;
@@ -45,8 +83,12 @@ private:
     vector<shared_ptr<Camera>> auxCameras;
     vector<shared_ptr<Water>> auxWaterObjects;
     const aiScene* auxScene;
+    const vector<Mesh::CookedGeometry>* auxCookedMeshes = nullptr;
+    TextureCache localTextures;
+    TextureCache* textureCache = &localTextures;
 
     shared_ptr<ShaderMaterialDefault> materialDefaultShader;
     shared_ptr<Shader> waterShader;
     shared_ptr<Shader> skyBoxShader;
+    shared_ptr<Hlod> hlod;
 };
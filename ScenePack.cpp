@@ -0,0 +1,567 @@
+#include "ScenePack.h"
+#include "AnimationClip.h"
+#include "SceneLoader.h"
+#include "Mesh.h"
+#include "Constants.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+
+namespace {
+    const size_t ALIGNMENT = 16;
+
+    // Builds the file in memory, the header slot at the start is filled in last
+    class PackWriter {
+    public:
+        PackWriter()
+        {
+            bytes.resize(align(sizeof(ScenePack::Header)));
+        }
+
+        ScenePack::Blob append(const void* data, const size_t size)
+        {
+            const ScenePack::Blob blob{ bytes.size(), size };
+            if (size > 0) {
+                bytes.insert(bytes.end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+                bytes.resize(align(bytes.size()));
+            }
+            return blob;
+        }
+
+        template <typename T>
+        ScenePack::Blob append(const std::vector<T>& values)
+        {
+            return append(values.data(), values.size() * sizeof(T));
+        }
+
+        ScenePack::Blob appendString(const std::string& value)
+        {
+            return append(value.data(), value.size());
+        }
+
+        ScenePack::Blob appendStrings(const std::vector<std::string>& values)
+        {
+            std::vector<ScenePack::Blob> blobs;
+            for (const auto& value : values) {
+                blobs.push_back(appendString(value));
+            }
+            return append(blobs);
+        }
+
+        void setHeader(const ScenePack::Header& header)
+        {
+            std::memcpy(bytes.data(), &header, sizeof(header));
+        }
+
+        bool write(const std::string& path) const
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            return file.good();
+        }
+
+    private:
+        static size_t align(const size_t size)
+        {
+            return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        }
+
+        std::vector<char> bytes;
+    };
+
+    std::vector<char> readFile(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return {};
+        }
+        return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    template <typename Named>
+    std::int32_t findByName(Named** items, const unsigned int count, const aiString& name)
+    {
+        for (auto i = 0u; i < count; ++i) {
+            if (items[i]->mName == name) {
+                return static_cast<std::int32_t>(i);
+            }
+        }
+        return -1;
+    }
+
+    void cookNode(const aiScene& scene, const aiNode& node, PackWriter& writer, std::vector<ScenePack::NodeRecord>& nodes)
+    {
+        ScenePack::NodeRecord record;
+        record.name = writer.appendString(node.mName.C_Str());
+        record.meshes = writer.append(node.mMeshes, node.mNumMeshes * sizeof(unsigned int));
+        record.light = findByName(scene.mLights, scene.mNumLights, node.mName);
+        record.camera = findByName(scene.mCameras, scene.mNumCameras, node.mName);
+        record.childCount = node.mNumChildren;
+        record.water = SceneLoader::readWaterModes(node);
+        aiVector3D position;
+        aiQuaternion rotation;
+        aiVector3D scale;
+        node.mTransformation.Decompose(scale, rotation, position);
+        const float positionValues[] = { position.x, position.y, position.z };
+        const float rotationValues[] = { rotation.x, rotation.y, rotation.z, rotation.w };
+        const float scaleValues[] = { scale.x, scale.y, scale.z };
+        std::memcpy(record.position, positionValues, sizeof(record.position));
+        std::memcpy(record.rotation, rotationValues, sizeof(record.rotation));
+        std::memcpy(record.scale, scaleValues, sizeof(record.scale));
+        nodes.push_back(record);
+        for (auto i = 0u; i < node.mNumChildren; ++i) {
+            cookNode(scene, *node.mChildren[i], writer, nodes);
+        }
+    }
+
+    ScenePack::MeshRecord cookMesh(const aiMesh* meshNode, const Mesh::CookedGeometry& cooked, PackWriter& writer)
+    {
+        const auto& geometry = cooked.geometry;
+        ScenePack::MeshRecord record;
+        record.vertexCount = geometry.vertexCount;
+        record.indexCount = geometry.indexCount;
+        record.material = meshNode->mMaterialIndex;
+        record.boneCount = static_cast<std::uint32_t>(geometry.boneNames.size());
+        record.closed = geometry.closed ? 1 : 0;
+        std::memcpy(record.minPoints, &geometry.minPoints[0], sizeof(record.minPoints));
+        std::memcpy(record.maxPoints, &geometry.maxPoints[0], sizeof(record.maxPoints));
+        // Compressed here so loading uploads the mapping as it is
+        Mesh::CompactGeometry compact;
+        compact.positionOffset = glm::vec3(0.0f);
+        compact.positionScale = glm::vec3(1.0f);
+        if (constants::COMPACT_VERTEX_FORMAT) {
+            Mesh::compress(geometry, compact);
+        }
+        std::memcpy(record.positionOffset, &compact.positionOffset[0], sizeof(record.positionOffset));
+        std::memcpy(record.positionScale, &compact.positionScale[0], sizeof(record.positionScale));
+        record.vertices = compact.positions.empty() ? writer.append(cooked.vertices) : ScenePack::Blob{ 0, 0 };
+        record.compactPositions = writer.append(compact.positions);
+        record.compactAttributes = writer.append(compact.attributes);
+        record.indices = compact.shortIndices.empty() ? writer.append(cooked.indices) : ScenePack::Blob{ 0, 0 };
+        record.shortIndices = writer.append(compact.shortIndices);
+        record.lods = writer.append(cooked.lods);
+        record.clusters = writer.append(cooked.clusters);
+        record.skin = writer.append(cooked.skin);
+        record.boneNames = writer.appendStrings(geometry.boneNames);
+        record.boneOffsets = writer.append(geometry.boneOffsets);
+        return record;
+    }
+
+    // The values SceneLoader::loadMaterial reads, with defaults for the keys a material leaves out
+    ScenePack::MaterialRecord cookMaterial(const aiMaterial& material, PackWriter& writer)
+    {
+        auto opacity = 1.0f;
+        material.Get(AI_MATKEY_OPACITY, opacity);
+        aiColor3D ambient;
+        material.Get(AI_MATKEY_COLOR_AMBIENT, ambient);
+        aiColor3D diffuse;
+        material.Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
+        aiColor3D specular;
+        material.Get(AI_MATKEY_COLOR_SPECULAR, specular);
+        aiColor3D emission;
+        material.Get(AI_MATKEY_COLOR_EMISSIVE, emission);
+        auto shininess = 0.0f;
+        material.Get(AI_MATKEY_SHININESS, shininess);
+
+        ScenePack::MaterialRecord record;
+        const float ambientValues[] = { ambient.r, ambient.g, ambient.b, opacity };
+        const float diffuseValues[] = { diffuse.r, diffuse.g, diffuse.b, opacity };
+        const float specularValues[] = { specular.r, specular.g, specular.b, 1.0f };
+        const float emissionValues[] = { emission.r, emission.g, emission.b, 0.0f };
+        std::memcpy(record.ambient, ambientValues, sizeof(record.ambient));
+        std::memcpy(record.diffuse, diffuseValues, sizeof(record.diffuse));
+        std::memcpy(record.specular, specularValues, sizeof(record.specular));
+        std::memcpy(record.emission, emissionValues, sizeof(record.emission));
+        record.shininess = shininess;
+
+        record.diffuseMapPath = ScenePack::Blob{ 0, 0 };
+        record.diffuseMap = ScenePack::Blob{ 0, 0 };
+        aiString texturePath;
+        if (material.GetTextureCount(aiTextureType_DIFFUSE) > 0
+            && material.GetTexture(aiTextureType_DIFFUSE, 0, &texturePath) == AI_SUCCESS) {
+            record.diffuseMapPath = writer.appendString(texturePath.C_Str());
+            const auto image = readFile(texturePath.C_Str());
+            if (image.empty()) {
+                printf("Scene pack: could not read %s, it will be loaded from disk\n", texturePath.C_Str());
+            }
+            record.diffuseMap = writer.append(image);
+        }
+        return record;
+    }
+
+    ScenePack::LightRecord cookLight(const aiLight& light, PackWriter& writer)
+    {
+        ScenePack::LightRecord record;
+        record.name = writer.appendString(light.mName.C_Str());
+        record.type = static_cast<std::uint32_t>(light.mType);
+        const float colors[3][3] = {
+            { light.mColorDiffuse.r, light.mColorDiffuse.g, light.mColorDiffuse.b },
+            { light.mColorAmbient.r, light.mColorAmbient.g, light.mColorAmbient.b },
+            { light.mColorSpecular.r, light.mColorSpecular.g, light.mColorSpecular.b }
+        };
+        const float attenuation[] = { light.mAttenuationConstant, light.mAttenuationLinear, light.mAttenuationQuadratic };
+        std::memcpy(record.diffuse, colors[0], sizeof(record.diffuse));
+        std::memcpy(record.ambient, colors[1], sizeof(record.ambient));
+        std::memcpy(record.specular, colors[2], sizeof(record.specular));
+        std::memcpy(record.attenuation, attenuation, sizeof(record.attenuation));
+        record.innerAngle = light.mAngleInnerCone;
+        record.outerAngle = light.mAngleOuterCone;
+        return record;
+    }
+
+    ScenePack::CameraRecord cookCamera(const aiCamera& camera, PackWriter& writer)
+    {
+        ScenePack::CameraRecord record;
+        record.name = writer.appendString(camera.mName.C_Str());
+        const float position[] = { camera.mPosition.x, camera.mPosition.y, camera.mPosition.z };
+        std::memcpy(record.position, position, sizeof(record.position));
+        return record;
+    }
+
+    template <typename T>
+    std::vector<T> concatenate(std::initializer_list<const std::vector<T>*> arrays)
+    {
+        std::vector<T> values;
+        for (const auto array : arrays) {
+            values.insert(values.end(), array->begin(), array->end());
+        }
+        return values;
+    }
+}
+
+bool ScenePack::cook(const aiScene& scene, const std::vector<Mesh::CookedGeometry>& cookedMeshes,
+                     const std::string& sourcePath, const std::string& path)
+{
+    Source source = {};
+    if (cookedMeshes.size() != scene.mNumMeshes || !readSource(sourcePath, source)) {
+        return false;
+    }
+    PackWriter writer;
+
+    std::vector<NodeRecord> nodes;
+    if (scene.mRootNode != nullptr) {
+        cookNode(scene, *scene.mRootNode, writer, nodes);
+    }
+    std::vector<MeshRecord> meshes;
+    for (auto i = 0u; i < scene.mNumMeshes; ++i) {
+        meshes.push_back(cookMesh(scene.mMeshes[i], cookedMeshes[i], writer));
+    }
+    std::vector<MaterialRecord> materials;
+    for (auto i = 0u; i < scene.mNumMaterials; ++i) {
+        materials.push_back(cookMaterial(*scene.mMaterials[i], writer));
+    }
+    std::vector<LightRecord> lights;
+    for (auto i = 0u; i < scene.mNumLights; ++i) {
+        lights.push_back(cookLight(*scene.mLights[i], writer));
+    }
+    std::vector<CameraRecord> cameras;
+    for (auto i = 0u; i < scene.mNumCameras; ++i) {
+        cameras.push_back(cookCamera(*scene.mCameras[i], writer));
+    }
+    std::vector<AnimationRecord> animations;
+    for (auto i = 0u; i < scene.mNumAnimations; ++i) {
+        const AnimationClip clip(*scene.mAnimations[i]);
+        AnimationRecord record;
+        record.channelCount = static_cast<std::uint32_t>(clip.channelCount);
+        record.stride = static_cast<std::uint32_t>(clip.stride);
+        record.sampleCount = clip.sampleCount;
+        record.quantized = clip.quantized ? 1 : 0;
+        record.gameplay = AnimationClip::isGameplay(scene, *scene.mAnimations[i]) ? 1 : 0;
+        record.sampleRate = clip.sampleRate;
+        record.duration = clip.duration;
+        record.ticksPerSecond = clip.ticksPerSecond;
+        record.channelNames = writer.appendStrings(clip.channelNames);
+        record.positionAnimated = writer.append(clip.positionAnimated);
+        record.rotationAnimated = writer.append(clip.rotationAnimated);
+        record.positions = writer.append(concatenate({ &clip.positionX, &clip.positionY, &clip.positionZ }));
+        if (clip.quantized) {
+            record.rotations = writer.append(concatenate({ &clip.packedRotationX, &clip.packedRotationY, &clip.packedRotationZ, &clip.packedRotationW }));
+        } else {
+            record.rotations = writer.append(concatenate({ &clip.rotationX, &clip.rotationY, &clip.rotationZ, &clip.rotationW }));
+        }
+        animations.push_back(record);
+    }
+
+    Header header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.source = source;
+    header.nodes = writer.append(nodes);
+    header.meshes = writer.append(meshes);
+    header.materials = writer.append(materials);
+    header.lights = writer.append(lights);
+    header.cameras = writer.append(cameras);
+    header.animations = writer.append(animations);
+    writer.setHeader(header);
+    return writer.write(path);
+}
+
+bool ScenePack::open(const std::string& path, const std::string& sourcePath)
+{
+    close();
+    if (!file.open(path) || file.size() < sizeof(Header)) {
+        file.close();
+        return false;
+    }
+    header = reinterpret_cast<const Header*>(file.data());
+    if (header->magic != MAGIC || header->version != VERSION || !validate()) {
+        close();
+        return false;
+    }
+    Source source;
+    if (readSource(sourcePath, source) && (source.size != header->source.size || source.modified != header->source.modified)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool ScenePack::readSource(const std::string& path, Source& source)
+{
+#ifdef _WIN32
+    struct _stat64 status;
+    if (_stat64(path.c_str(), &status) != 0) {
+        return false;
+    }
+#else
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0) {
+        return false;
+    }
+#endif
+    source.size = static_cast<std::uint64_t>(status.st_size);
+    source.modified = static_cast<std::int64_t>(status.st_mtime);
+    return true;
+}
+
+void ScenePack::close()
+{
+    file.close();
+    header = nullptr;
+}
+
+bool ScenePack::contains(const Blob& blob) const
+{
+    return blob.offset % ALIGNMENT == 0 && blob.offset <= file.size() && blob.size <= file.size() - blob.offset;
+}
+
+bool ScenePack::containsStrings(const Blob& blob) const
+{
+    if (!contains(blob) || blob.size % sizeof(Blob) != 0) {
+        return false;
+    }
+    for (const auto& string : getTable<Blob>(blob)) {
+        if (!contains(string)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ScenePack::validate() const
+{
+    for (const auto& table : { header->nodes, header->meshes, header->materials, header->lights, header->cameras, header->animations }) {
+        if (!contains(table)) {
+            return false;
+        }
+    }
+    if (header->nodes.size % sizeof(NodeRecord) != 0 || header->meshes.size % sizeof(MeshRecord) != 0
+        || header->materials.size % sizeof(MaterialRecord) != 0 || header->lights.size % sizeof(LightRecord) != 0
+        || header->cameras.size % sizeof(CameraRecord) != 0 || header->animations.size % sizeof(AnimationRecord) != 0) {
+        return false;
+    }
+
+    const auto meshes = getMeshes();
+    const auto materials = getMaterials();
+    const auto lights = getLights();
+    const auto cameras = getCameras();
+    // Every node but the root is some node's child, so the child counts have to add up to the node count
+    size_t pending = 1;
+    for (const auto& node : getNodes()) {
+        if (pending == 0 || !contains(node.name) || !contains(node.meshes) || node.meshes.size % sizeof(std::uint32_t) != 0
+            || node.light >= static_cast<std::int64_t>(lights.count) || node.camera >= static_cast<std::int64_t>(cameras.count)) {
+            return false;
+        }
+        const auto meshIndices = static_cast<const std::uint32_t*>(getData(node.meshes));
+        for (size_t i = 0; i < node.meshes.size / sizeof(std::uint32_t); ++i) {
+            if (meshIndices[i] >= meshes.count) {
+                return false;
+            }
+        }
+        pending = pending - 1 + node.childCount;
+    }
+    if (pending != 0) {
+        return false;
+    }
+
+    for (const auto& mesh : meshes) {
+        // One of the two vertex formats and one of the two index sizes, 16 bit ones only with compact vertices
+        const auto compact = mesh.compactPositions.size != 0;
+        const auto shortIndices = mesh.shortIndices.size != 0;
+        if (!contains(mesh.vertices) || mesh.vertices.size != (compact ? 0 : mesh.vertexCount * sizeof(Mesh::Vertex))
+            || !contains(mesh.compactPositions) || !contains(mesh.compactAttributes)
+            || mesh.compactAttributes.size != (compact ? mesh.vertexCount * sizeof(Mesh::CompactAttributes) : 0)
+            || (compact && mesh.compactPositions.size != mesh.vertexCount * sizeof(Mesh::CompactPosition))
+            || (shortIndices && !compact)
+            || !contains(mesh.indices) || mesh.indices.size != (shortIndices ? 0 : mesh.indexCount * sizeof(std::uint32_t))
+            || !contains(mesh.shortIndices) || (shortIndices && mesh.shortIndices.size != mesh.indexCount * sizeof(std::uint16_t))
+            || !contains(mesh.skin) || (mesh.skin.size != 0 && mesh.skin.size != mesh.vertexCount * sizeof(Mesh::SkinVertex))
+            || !containsStrings(mesh.boneNames) || mesh.boneNames.size != mesh.boneCount * sizeof(Blob)
+            || !contains(mesh.boneOffsets) || mesh.boneOffsets.size != mesh.boneCount * 16 * sizeof(float)
+            || mesh.material >= materials.count) {
+            return false;
+        }
+        const auto indices = static_cast<const std::uint32_t*>(getData(mesh.indices));
+        const auto shortIndexData = static_cast<const std::uint16_t*>(getData(mesh.shortIndices));
+        for (auto i = 0u; i < mesh.indexCount; ++i) {
+            if ((shortIndices ? shortIndexData[i] : indices[i]) >= mesh.vertexCount) {
+                return false;
+            }
+        }
+        if (!contains(mesh.lods) || mesh.lods.size % sizeof(Mesh::Lod) != 0
+            || !contains(mesh.clusters) || mesh.clusters.size % sizeof(Mesh::Cluster) != 0) {
+            return false;
+        }
+        const auto lods = static_cast<const Mesh::Lod*>(getData(mesh.lods));
+        const auto clusters = static_cast<const Mesh::Cluster*>(getData(mesh.clusters));
+        const auto clusterCount = mesh.clusters.size / sizeof(Mesh::Cluster);
+        for (size_t i = 0; i < mesh.lods.size / sizeof(Mesh::Lod); ++i) {
+            const auto& lod = lods[i];
+            if (lod.indexCount % 3 != 0 || lod.indexOffset > mesh.indexCount || lod.indexCount > mesh.indexCount - lod.indexOffset
+                || lod.clusterOffset > clusterCount || lod.clusterCount > clusterCount - lod.clusterOffset) {
+                return false;
+            }
+            // Clusters draw in place of their level, so they must stay inside it
+            for (auto c = lod.clusterOffset; c < lod.clusterOffset + lod.clusterCount; ++c) {
+                if (clusters[c].indexOffset < lod.indexOffset || clusters[c].indexCount > lod.indexCount
+                    || clusters[c].indexOffset - lod.indexOffset > lod.indexCount - clusters[c].indexCount) {
+                    return false;
+                }
+            }
+        }
+    }
+    for (const auto& material : materials) {
+        if (!contains(material.diffuseMapPath) || !contains(material.diffuseMap)) {
+            return false;
+        }
+    }
+    for (const auto& light : lights) {
+        if (!contains(light.name)) {
+            return false;
+        }
+    }
+    for (const auto& camera : cameras) {
+        if (!contains(camera.name)) {
+            return false;
+        }
+    }
+    for (const auto& animation : getAnimations()) {
+        const auto size = static_cast<std::uint64_t>(animation.sampleCount) * animation.stride;
+        const auto rotationSize = animation.quantized ? sizeof(std::int16_t) : sizeof(float);
+        // The sampler works on whole groups of four channels
+        if (animation.stride < animation.channelCount || animation.stride % 4 != 0 || animation.sampleCount == 0
+            || !containsStrings(animation.channelNames) || animation.channelNames.size != animation.channelCount * sizeof(Blob)
+            || !contains(animation.positionAnimated) || animation.positionAnimated.size != animation.channelCount
+            || !contains(animation.rotationAnimated) || animation.rotationAnimated.size != animation.channelCount
+            || !contains(animation.positions) || animation.positions.size != 3 * size * sizeof(float)
+            || !contains(animation.rotations) || animation.rotations.size != 4 * size * rotationSize) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+ScenePack::Table<T> ScenePack::getTable(const Blob& blob) const
+{
+    return Table<T>{ static_cast<const T*>(getData(blob)), static_cast<size_t>(blob.size / sizeof(T)) };
+}
+
+ScenePack::Table<ScenePack::NodeRecord> ScenePack::getNodes() const
+{
+    return getTable<NodeRecord>(header->nodes);
+}
+
+ScenePack::Table<ScenePack::MeshRecord> ScenePack::getMeshes() const
+{
+    return getTable<MeshRecord>(header->meshes);
+}
+
+ScenePack::Table<ScenePack::MaterialRecord> ScenePack::getMaterials() const
+{
+    return getTable<MaterialRecord>(header->materials);
+}
+
+ScenePack::Table<ScenePack::LightRecord> ScenePack::getLights() const
+{
+    return getTable<LightRecord>(header->lights);
+}
+
+ScenePack::Table<ScenePack::CameraRecord> ScenePack::getCameras() const
+{
+    return getTable<CameraRecord>(header->cameras);
+}
+
+ScenePack::Table<ScenePack::AnimationRecord> ScenePack::getAnimations() const
+{
+    return getTable<AnimationRecord>(header->animations);
+}
+
+const void* ScenePack::getData(const Blob& blob) const
+{
+    return file.data() + blob.offset;
+}
+
+std::string ScenePack::getString(const Blob& blob) const
+{
+    return std::string(static_cast<const char*>(getData(blob)), static_cast<size_t>(blob.size));
+}
+
+std::vector<std::string> ScenePack::getStrings(const Blob& blob) const
+{
+    std::vector<std::string> strings;
+    for (const auto& string : getTable<Blob>(blob)) {
+        strings.push_back(getString(string));
+    }
+    return strings;
+}
+
+std::shared_ptr<AnimationClip> ScenePack::loadAnimation(const AnimationRecord& record) const
+{
+    const std::shared_ptr<AnimationClip> clip(new AnimationClip());
+    clip->channelCount = record.channelCount;
+    clip->stride = record.stride;
+    clip->sampleCount = record.sampleCount;
+    clip->quantized = record.quantized != 0;
+    clip->sampleRate = record.sampleRate;
+    clip->duration = record.duration;
+    clip->ticksPerSecond = record.ticksPerSecond;
+    clip->channelNames = getStrings(record.channelNames);
+    const auto positionAnimated = static_cast<const std::uint8_t*>(getData(record.positionAnimated));
+    clip->positionAnimated.assign(positionAnimated, positionAnimated + record.channelCount);
+    const auto rotationAnimated = static_cast<const std::uint8_t*>(getData(record.rotationAnimated));
+    clip->rotationAnimated.assign(rotationAnimated, rotationAnimated + record.channelCount);
+
+    // The sampler reads whole lanes from owned arrays, so these are copied out of the mapping
+    const auto size = static_cast<size_t>(record.sampleCount) * record.stride;
+    const auto positions = static_cast<const float*>(getData(record.positions));
+    clip->positionX.assign(positions, positions + size);
+    clip->positionY.assign(positions + size, positions + 2 * size);
+    clip->positionZ.assign(positions + 2 * size, positions + 3 * size);
+    if (clip->quantized) {
+        const auto rotations = static_cast<const std::int16_t*>(getData(record.rotations));
+        clip->packedRotationX.assign(rotations, rotations + size);
+        clip->packedRotationY.assign(rotations + size, rotations + 2 * size);
+        clip->packedRotationZ.assign(rotations + 2 * size, rotations + 3 * size);
+        clip->packedRotationW.assign(rotations + 3 * size, rotations + 4 * size);
+    } else {
+        const auto rotations = static_cast<const float*>(getData(record.rotations));
+        clip->rotationX.assign(rotations, rotations + size);
+        clip->rotationY.assign(rotations + size, rotations + 2 * size);
+        clip->rotationZ.assign(rotations + 2 * size, rotations + 3 * size);
+        clip->rotationW.assign(rotations + 3 * size, rotations + 4 * size);
+    }
+    return clip;
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include "MappedFile.h"
+#include "Mesh.h"
+#include "WaterModes.h"
+#include <assimp/scene.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class AnimationClip;
+
+// A scene cooked offline into one binary file that is memory mapped at startup. Everything Assimp and the
+// loaders would otherwise compute is stored finished: the node hierarchy with decomposed transforms, vertex and
+// index arrays in the exact layout Mesh uploads, evaluated materials with their texture files embedded, and
+// the animations already baked into clips. Loading is reading tables and handing pointers into the mapping to
+// GL. Records are plain structs written in the native layout, the version changes whenever one of them does.
+class ScenePack {
+public:
+    static const std::uint32_t MAGIC = 0x4B415053; // "SPAK"
+    static const std::uint32_t VERSION = 8;
+
+    // Bytes at an offset from the start of the file, 16 byte aligned
+    struct Blob {
+        std::uint64_t offset;
+        std::uint64_t size;
+    };
+
+    template <typename T>
+    struct Table {
+        const T* data;
+        size_t count;
+        const T* begin() const { return data; }
+        const T* end() const { return data + count; }
+        const T& operator[](size_t i) const { return data[i]; }
+    };
+
+    // Pre-order, children follow their parent
+    struct NodeRecord {
+        Blob name;
+        Blob meshes; // uint32 indices into the mesh table
+        std::int32_t light; // index into the light table, -1 for none
+        std::int32_t camera;
+        std::uint32_t childCount;
+        float position[3];
+        float rotation[4]; // x y z w
+        float scale[3];
+        WaterModes water; // read from the node's metadata, used when the node is a water body
+    };
+
+    struct MeshRecord {
+        std::uint32_t vertexCount;
+        std::uint32_t indexCount;
+        std::uint32_t material;
+        std::uint32_t boneCount;
+        float minPoints[3];
+        float maxPoints[3];
+        std::uint32_t closed; // Mesh::Geometry::closed
+        float positionOffset[3]; // decode compactPositions
+        float positionScale[3];
+        // The vertices in the format Mesh uploads: Mesh::Vertex, or both compact streams when COMPACT_VERTEX_FORMAT
+        // was on at cook time. The indices cover every level of detail, uint16 whenever the compact vertices fit.
+        Blob vertices;
+        Blob compactPositions; // Mesh::CompactPosition
+        Blob compactAttributes; // Mesh::CompactAttributes
+        Blob indices; // uint32
+        Blob shortIndices; // uint16
+        Blob lods; // Mesh::Lod per level, the full one first
+        Blob clusters; // Mesh::Cluster, the levels' clusters one after the other
+        Blob skin; // Mesh::SkinVertex, empty when not skinned
+        Blob boneNames; // Blob per bone
+        Blob boneOffsets; // column major mat4 per bone
+    };
+
+    struct MaterialRecord {
+        float ambient[4];
+        float diffuse[4];
+        float specular[4];
+        float emission[4];
+        float shininess;
+        Blob diffuseMapPath; // empty without a diffuse map
+        Blob diffuseMap; // the image file, empty when it could not be read at cook time
+    };
+
+    struct LightRecord {
+        Blob name;
+        std::uint32_t type; // aiLightSourceType
+        float diffuse[3];
+        float ambient[3];
+        float specular[3];
+        float attenuation[3]; // constant, linear, quadratic
+        float innerAngle;
+        float outerAngle;
+    };
+
+    struct CameraRecord {
+        Blob name;
+        float position[3];
+    };
+
+    struct AnimationRecord {
+        std::uint32_t channelCount;
+        std::uint32_t stride; // channels padded to the sampler's lanes
+        std::uint32_t sampleCount;
+        std::uint32_t quantized;
+        std::uint32_t gameplay; // keeps playing off screen, see AnimationClip::isGameplay
+        float sampleRate;
+        float duration;
+        double ticksPerSecond;
+        Blob channelNames; // Blob per channel
+        Blob positionAnimated; // uint8 per channel
+        Blob rotationAnimated;
+        Blob positions; // x, y then z arrays of sampleCount * stride floats
+        Blob rotations; // x, y, z then w arrays, int16 when quantized
+    };
+
+    // The file a pack was cooked from, as it was then
+    struct Source {
+        std::uint64_t size;
+        std::int64_t modified; // seconds since the epoch
+    };
+
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        Source source;
+        Blob nodes;
+        Blob meshes;
+        Blob materials;
+        Blob lights;
+        Blob cameras;
+        Blob animations;
+    };
+
+    // Writes scene, imported from sourcePath with SceneLoader::importScene, to path, with cookedMeshes holding
+    // Mesh::cook of every one of its meshes in order as SceneLoader::cookMeshes leaves them. Needs no GL context.
+    static bool cook(const aiScene& scene, const std::vector<Mesh::CookedGeometry>& cookedMeshes,
+                     const std::string& sourcePath, const std::string& path);
+
+    // Maps the pack and checks every table and blob lies inside it, false for a missing, foreign, outdated or
+    // truncated file, or one cooked from another revision of sourcePath. Without the source the pack is trusted.
+    bool open(const std::string& path, const std::string& sourcePath);
+    void close();
+
+    Table<NodeRecord> getNodes() const;
+    Table<MeshRecord> getMeshes() const;
+    Table<MaterialRecord> getMaterials() const;
+    Table<LightRecord> getLights() const;
+    Table<CameraRecord> getCameras() const;
+    Table<AnimationRecord> getAnimations() const;
+
+    const void* getData(const Blob& blob) const;
+    std::string getString(const Blob& blob) const;
+    std::vector<std::string> getStrings(const Blob& blob) const; // a Blob of Blobs
+    std::shared_ptr<AnimationClip> loadAnimation(const AnimationRecord& record) const;
+
+private:
+    static bool readSource(const std::string& path, Source& source);
+    template <typename T>
+    Table<T> getTable(const Blob& blob) const;
+    bool contains(const Blob& blob) const;
+    bool containsStrings(const Blob& blob) const;
+    bool validate() const;
+
+    MappedFile file;
+    const Header* header = nullptr;
+};
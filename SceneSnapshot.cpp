@@ -0,0 +1,44 @@
+#include "SceneSnapshot.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+
+void SceneSnapshot::interpolate()
+{
+    const auto t = interpolation;
+    const auto position = mix(previous.cameraPosition, current.cameraPosition, t);
+    const auto front = normalize(mix(previous.cameraFront, current.cameraFront, t));
+    const auto up = normalize(mix(previous.cameraUp, current.cameraUp, t));
+    camera = RenderView(glm::lookAt(position, position + front, up), current.cameraProjection, position);
+
+    // Both states always hold the same meshes, the sync point resets previous whenever the hierarchy changes
+    meshModels.resize(current.meshTransforms.size());
+    for (auto i = 0u; i < meshModels.size(); ++i) {
+        const auto& from = previous.meshTransforms[i];
+        const auto& to = current.meshTransforms[i];
+        // Same composition as Transform::getModelMatrix
+        auto model = translate(glm::mat4(1.0f), mix(from.position, to.position, t));
+        model *= mat4_cast(slerp(from.rotation, to.rotation, t));
+        meshModels[i] = glm::scale(model, mix(from.scale, to.scale, t));
+    }
+
+    // Bone matrices are relative to their mesh and move little in one step, blending them linearly is enough
+    skinPalettes.resize(current.skinPalettes.size());
+    for (auto i = 0u; i < skinPalettes.size(); ++i) {
+        const auto& from = previous.skinPalettes[i];
+        const auto& to = current.skinPalettes[i];
+        auto& palette = skinPalettes[i];
+        palette.resize(to.size());
+        for (auto bone = 0u; bone < palette.size(); ++bone) {
+            palette[bone] = from[bone] * (1.0f - t) + to[bone] * t;
+        }
+    }
+
+    waterModels = current.waterModels;
+    // The phase wraps around, blend forward across the wrap
+    auto moveDelta = current.waterMoveFactor - previous.waterMoveFactor;
+    if (moveDelta < 0.0f) {
+        moveDelta += 1.0f;
+    }
+    waterMoveFactor = previous.waterMoveFactor + moveDelta * t;
+    waterMoveFactor -= std::floor(waterMoveFactor);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "RenderView.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <vector>
+
+struct TransformState {
+    glm::vec3 position;
+    glm::quat rotation;
+    glm::vec3 scale;
+};
+
+// What one fixed simulation step leaves for rendering
+struct SimulationState {
+    glm::vec3 cameraPosition;
+    glm::vec3 cameraFront;
+    glm::vec3 cameraUp;
+    glm::mat4 cameraProjection;
+    std::vector<TransformState> meshTransforms; // same order as MainWindow::drawables
+    std::vector<glm::mat4> waterModels; // same order as MainWindow::waterObjects
+    std::vector<std::vector<glm::mat4>> skinPalettes; // same order as MainWindow::skinnedDrawables
+    float waterMoveFactor = 0.0f;
+};
+
+// Everything update produces that the render thread reads. Rendering falls between the last two simulated
+// states, interpolate() blends them by how far real time got into the next step and builds the matrices the
+// passes use. MainWindow keeps two: while one frame draws from its snapshot, the simulation of the next frame
+// fills the other one. Lights are left out, their matrices are fixed once the scene is mounted.
+struct SceneSnapshot {
+    SimulationState previous;
+    SimulationState current;
+    float interpolation = 1.0f;
+
+    RenderView camera = RenderView(glm::mat4(1.0f), glm::mat4(1.0f), glm::vec3(0.0f));
+    std::vector<glm::mat4> meshModels;
+    std::vector<glm::mat4> waterModels;
+    std::vector<std::vector<glm::mat4>> skinPalettes;
+    float waterMoveFactor = 0.0f;
+
+    void interpolate();
+};
@@ -0,0 +1,131 @@
+#include "SceneUpdater.h"
+#include <unordered_map>
+
+namespace {
+    int findGroup(std::vector<int>& groupOf, int node)
+    {
+        while (groupOf[node] != node) {
+            groupOf[node] = groupOf[groupOf[node]];
+            node = groupOf[node];
+        }
+        return node;
+    }
+}
+
+void SceneUpdater::build(const shared_ptr<GameObject>& root)
+{
+    nodes.clear();
+    addNode(root, -1, 0);
+
+    std::unordered_map<const GameObject*, int> indices;
+    for (auto i = 0u; i < nodes.size(); ++i) {
+        indices[nodes[i].object] = static_cast<int>(i);
+    }
+    std::vector<int> groupOf(nodes.size());
+    for (auto i = 0u; i < nodes.size(); ++i) {
+        groupOf[i] = static_cast<int>(i);
+    }
+    // Every dependent is linked to the object it touches and to the previous dependent of that object,
+    // two of them writing a common ancestor must not run side by side either
+    std::unordered_map<int, int> lastDependent;
+    for (auto i = 0u; i < nodes.size(); ++i) {
+        for (const auto& dependency : nodes[i].object->getUpdateDependencies()) {
+            const auto target = indices.find(dependency.get());
+            if (target == indices.end()) {
+                continue;
+            }
+            link(static_cast<int>(i), target->second, groupOf);
+            const auto previous = lastDependent.find(target->second);
+            if (previous != lastDependent.end()) {
+                link(static_cast<int>(i), previous->second, groupOf);
+            }
+            lastDependent[target->second] = static_cast<int>(i);
+        }
+    }
+
+    for (auto& node : nodes) {
+        std::unordered_map<int, size_t> groupIndex;
+        for (const auto child : node.children) {
+            const auto group = findGroup(groupOf, child);
+            const auto existing = groupIndex.find(group);
+            if (existing == groupIndex.end()) {
+                groupIndex[group] = node.childGroups.size();
+                node.childGroups.push_back({ child });
+            } else {
+                node.childGroups[existing->second].push_back(child);
+            }
+        }
+    }
+}
+
+int SceneUpdater::addNode(const shared_ptr<GameObject>& object, const int parent, const int depth)
+{
+    const auto index = static_cast<int>(nodes.size());
+    nodes.push_back(Node{ object.get(), parent, depth, 1, {}, {} });
+    for (const auto& child : object->getChildren()) {
+        const auto childIndex = addNode(child, index, depth + 1);
+        nodes[index].children.push_back(childIndex);
+        nodes[index].subtreeSize += nodes[childIndex].subtreeSize;
+    }
+    return index;
+}
+
+void SceneUpdater::link(int a, int b, std::vector<int>& groupOf) const
+{
+    // Climb to the children of the lowest common ancestor, those are the siblings that can't run together.
+    // When one object is an ancestor of the other they never overlap: the ancestor waits for its subtree.
+    while (nodes[a].depth > nodes[b].depth) {
+        a = nodes[a].parent;
+    }
+    while (nodes[b].depth > nodes[a].depth) {
+        b = nodes[b].parent;
+    }
+    if (a == b) {
+        return;
+    }
+    while (nodes[a].parent != nodes[b].parent) {
+        a = nodes[a].parent;
+        b = nodes[b].parent;
+    }
+    groupOf[findGroup(groupOf, a)] = findGroup(groupOf, b);
+}
+
+void SceneUpdater::update(JobSystem& jobSystem) const
+{
+    if (!nodes.empty()) {
+        updateNode(jobSystem, 0);
+    }
+}
+
+void SceneUpdater::updateNode(JobSystem& jobSystem, const int index) const
+{
+    const auto& node = nodes[index];
+    if (node.subtreeSize <= constants::UPDATE_JOB_MIN_OBJECTS) {
+        node.object->callUpdate();
+        return;
+    }
+    // Small groups are batched until a job carries enough objects, the last batch stays on this thread
+    JobSystem::JobGroup jobs;
+    std::vector<int> batch;
+    auto batchSize = 0;
+    for (auto group = 0u; group < node.childGroups.size(); ++group) {
+        for (const auto child : node.childGroups[group]) {
+            batch.push_back(child);
+            batchSize += nodes[child].subtreeSize;
+        }
+        if (batchSize >= constants::UPDATE_JOB_MIN_OBJECTS && group + 1 < node.childGroups.size()) {
+            jobSystem.run(jobs, [this, &jobSystem, batch] {
+                for (const auto child : batch) {
+                    updateNode(jobSystem, child);
+                }
+            });
+            batch.clear();
+            batchSize = 0;
+        }
+    }
+    for (const auto child : batch) {
+        updateNode(jobSystem, child);
+    }
+    jobSystem.wait(jobs);
+    node.object->callLocalUpdate();
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "GameObject.h"
+#include "JobSystem.h"
+#include <vector>
+
+// GameObject::callUpdate spread over a JobSystem. Every object still updates after its children, so a parent
+// keeps the last word on the transforms it propagates down. Sibling subtrees touch disjoint objects and update
+// as parallel jobs, unless a declared update dependency links them: linked siblings form one group that keeps
+// the serial order. Subtrees below UPDATE_JOB_MIN_OBJECTS objects aren't worth a job and run inline.
+// The plan is built once for a fixed hierarchy and has to be rebuilt when objects are added or moved.
+class SceneUpdater {
+public:
+    void build(const shared_ptr<GameObject>& root);
+    void update(JobSystem& jobSystem) const;
+
+private:
+    struct Node {
+        GameObject* object;
+        int parent;
+        int depth;
+        int subtreeSize;
+        std::vector<int> children;
+        std::vector<std::vector<int>> childGroups; // each group updates serially, groups in parallel
+    };
+
+    int addNode(const shared_ptr<GameObject>& object, int parent, int depth);
+    void link(int a, int b, std::vector<int>& groupOf) const;
+    void updateNode(JobSystem& jobSystem, int node) const;
+
+    std::vector<Node> nodes;
+};
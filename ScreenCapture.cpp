@@ -0,0 +1,145 @@
+#include "ScreenCapture.h"
+#include "OpenGLImports.h"
+#include "ShaderDepthPyramid.h"
+#include <algorithm>
+
+ScreenCapture::ScreenCapture(const int width, const int height)
+{
+    this->width = width;
+    this->height = height;
+
+    glGenTextures(1, &colorTexture);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // DEPTH PYRAMID
+    depthPyramidLevels = 1;
+    for (auto size = std::max(width, height); size > 1; size /= 2) {
+        ++depthPyramidLevels;
+    }
+    glGenTextures(1, &depthPyramid);
+    glBindTexture(GL_TEXTURE_2D, depthPyramid);
+    for (auto level = 0; level < depthPyramidLevels; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, std::max(width >> level, 1), std::max(height >> level, 1), 0, GL_RED, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, depthPyramidLevels - 1);
+    glGenFramebuffers(1, &depthPyramidFrameBuffer);
+    glGenVertexArrays(1, &emptyVao);
+    depthPyramidShader = std::make_unique<ShaderDepthPyramid>(nullptr);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+ScreenCapture::~ScreenCapture()
+{
+    glDeleteTextures(1, &colorTexture);
+    glDeleteTextures(1, &depthTexture);
+    glDeleteTextures(1, &depthPyramid);
+    glDeleteFramebuffers(1, &depthPyramidFrameBuffer);
+    glDeleteVertexArrays(1, &emptyVao);
+}
+
+void ScreenCapture::buildDepthPyramid() const
+{
+    GLint oldDepthFuncMode;
+    glGetIntegerv(GL_DEPTH_FUNC, &oldDepthFuncMode);
+    glDepthFunc(GL_ALWAYS);
+    glDepthMask(GL_FALSE);
+    glBindFramebuffer(GL_FRAMEBUFFER, depthPyramidFrameBuffer);
+    glBindVertexArray(emptyVao);
+    depthPyramidShader->use();
+    glActiveTexture(GL_TEXTURE0 + constants::DEPTH_PYRAMID_GL_PLACE);
+
+    for (auto level = 0; level < depthPyramidLevels; ++level) {
+        const auto levelWidth = std::max(width >> level, 1);
+        const auto levelHeight = std::max(height >> level, 1);
+        if (level == 0) {
+            glBindTexture(GL_TEXTURE_2D, depthTexture);
+            depthPyramidShader->setPreviousLevel(constants::DEPTH_PYRAMID_GL_PLACE, width, height, true);
+        } else {
+            // Sample only the previous level while rendering into this one
+            glBindTexture(GL_TEXTURE_2D, depthPyramid);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+            depthPyramidShader->setPreviousLevel(constants::DEPTH_PYRAMID_GL_PLACE, std::max(width >> (level - 1), 1), std::max(height >> (level - 1), 1), false);
+        }
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, depthPyramid, level);
+        glViewport(0, 0, levelWidth, levelHeight);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, depthPyramid);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, depthPyramidLevels - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(oldDepthFuncMode);
+}
+
+int ScreenCapture::bindDepthPyramid(const int place) const
+{
+    glActiveTexture(GL_TEXTURE0 + place);
+    glBindTexture(GL_TEXTURE_2D, depthPyramid);
+    return place;
+}
+
+int ScreenCapture::getDepthPyramidLevels() const
+{
+    return depthPyramidLevels;
+}
+
+void ScreenCapture::capture() const
+{
+    // glCopyTexSubImage2D converts formats, unlike a depth blit from the default framebuffer
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+int ScreenCapture::bindColorTexture(const int place) const
+{
+    glActiveTexture(GL_TEXTURE0 + place);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    return place;
+}
+
+int ScreenCapture::bindDepthTexture(const int place) const
+{
+    glActiveTexture(GL_TEXTURE0 + place);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    return place;
+}
+
+unsigned int ScreenCapture::getColorTexture() const
+{
+    return colorTexture;
+}
+
+unsigned int ScreenCapture::getDepthTexture() const
+{
+    return depthTexture;
+}
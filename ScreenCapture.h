@@ -0,0 +1,33 @@
+#pragma once
+#include <memory>
+
+class ShaderDepthPyramid;
+
+// Copy of the default framebuffer's color and depth, sampled by effects that reuse the main pass
+class ScreenCapture {
+public:
+    ScreenCapture(int width, int height);
+    ~ScreenCapture();
+    void capture() const;
+    int bindColorTexture(int place) const;
+    int bindDepthTexture(int place) const;
+    unsigned int getColorTexture() const;
+    unsigned int getDepthTexture() const;
+
+    // Min-depth mip chain of the captured depth, for hierarchical-Z ray marching
+    void buildDepthPyramid() const;
+    int bindDepthPyramid(int place) const;
+    int getDepthPyramidLevels() const;
+
+private:
+    int width;
+    int height;
+    unsigned int colorTexture;
+    unsigned int depthTexture;
+
+    int depthPyramidLevels;
+    unsigned int depthPyramid;
+    unsigned int depthPyramidFrameBuffer;
+    unsigned int emptyVao;
+    std::unique_ptr<ShaderDepthPyramid> depthPyramidShader;
+};
@@ -1,81 +1,88 @@
 #include "Shader.h"
 #include "OpenGLImports.h"
+#include "Constants.h"
 #include <iostream>
 #include <fstream>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath, const shared_ptr<GameObject>& parent)
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const shared_ptr<GameObject>& parent, const char* geometryPath)
     : Component("shader", parent)
 {
-    // 1. retrieve the vertex/fragment source code from filePath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
+    ID = compileProgram(vertexPath, fragmentPath, geometryPath);
+}
+
+std::string Shader::readShaderFile(const char* path)
+{
+    std::ifstream shaderFile;
     // ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     try {
-        // open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
+        shaderFile.open(path);
+        std::stringstream shaderStream;
         // read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        // convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        shaderStream << shaderFile.rdbuf();
+        shaderFile.close();
+        return shaderStream.str();
     } catch (std::ifstream::failure e) {
-        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
     }
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+    return "";
+}
 
-    // 2. compile shaders
-    unsigned int vertex, fragment;
+unsigned int Shader::compileStage(const unsigned int type, const std::string& code)
+{
+    const char* shaderCode = code.c_str();
     int success;
     char infoLog[512];
 
-    // vertex Shader
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, nullptr);
-    glCompileShader(vertex);
+    const auto shader = glCreateShader(type);
+    glShaderSource(shader, 1, &shaderCode, nullptr);
+    glCompileShader(shader);
     // print compile errors if any
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success) {
-        glGetShaderInfoLog(vertex, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+        const auto stage = type == GL_VERTEX_SHADER ? "VERTEX" : type == GL_GEOMETRY_SHADER ? "GEOMETRY" : "FRAGMENT";
+        std::cout << "ERROR::SHADER::" << stage << "::COMPILATION_FAILED\n" << infoLog << std::endl;
     }
+    return shader;
+}
 
-    // similar for Fragment Shader
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, nullptr);
-    glCompileShader(fragment);
-    // print compile errors if any
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragment, 512, nullptr, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
+unsigned int Shader::compileProgram(const char* vertexPath, const char* fragmentPath, const char* geometryPath)
+{
+    // 1. retrieve the source code from filePath and compile the stages
+    const auto vertex = compileStage(GL_VERTEX_SHADER, readShaderFile(vertexPath));
+    const auto fragment = compileStage(GL_FRAGMENT_SHADER, readShaderFile(fragmentPath));
+    const auto geometry = geometryPath ? compileStage(GL_GEOMETRY_SHADER, readShaderFile(geometryPath)) : 0u;
 
-    // shader Program
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
-    glLinkProgram(ID);
+    // 2. shader Program
+    int success;
+    char infoLog[512];
+    const auto program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    if (geometry) {
+        glAttachShader(program, geometry);
+    }
+    glLinkProgram(program);
     // print linking errors if any
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
-        glGetProgramInfoLog(ID, 512, nullptr, infoLog);
+        glGetProgramInfoLog(program, 512, nullptr, infoLog);
         std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
     }
+    // GLSL 330 can't pick block bindings itself, skinned meshes bind their palette here
+    const auto bonePalette = glGetUniformBlockIndex(program, "BonePalette");
+    if (bonePalette != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, bonePalette, constants::BONE_PALETTE_BINDING);
+    }
 
     // delete the shaders as they're linked into our program now and no longer necessary
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+    if (geometry) {
+        glDeleteShader(geometry);
+    }
+    return program;
 }
 
 Shader::~Shader()
@@ -117,6 +124,11 @@ void Shader::setVec2(const std::string& name, float x, float y) const
     glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
 }
 
+void Shader::setIVec2(const std::string& name, int x, int y) const
+{
+    glUniform2i(glGetUniformLocation(ID, name.c_str()), x, y);
+}
+
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const
 {
     glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
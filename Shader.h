@@ -13,7 +13,7 @@ public:
     unsigned int ID;
 
     // constructor reads and builds the shader
-    Shader(const char* vertexPath, const char* fragmentPath, const shared_ptr<GameObject>& parent);
+    Shader(const char* vertexPath, const char* fragmentPath, const shared_ptr<GameObject>& parent, const char* geometryPath = nullptr);
     ~Shader();
 
     ComponentKey getComponentKey() override;
@@ -28,6 +28,7 @@ public:
     // ------------------------------------------------------------------------
     void setVec2(const std::string& name, const glm::vec2& value) const;
     void setVec2(const std::string& name, float x, float y) const;
+    void setIVec2(const std::string& name, int x, int y) const;
     // ------------------------------------------------------------------------
     void setVec3(const std::string& name, const glm::vec3& value) const;
     void setVec3(const std::string& name, float x, float y, float z) const;
@@ -40,4 +41,11 @@ public:
     void setMat3(const std::string& name, const glm::mat3& mat) const;
     // ------------------------------------------------------------------------
     void setMat4(const std::string& name, const glm::mat4& mat) const;
+
+protected:
+    static unsigned int compileProgram(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr);
+
+private:
+    static std::string readShaderFile(const char* path);
+    static unsigned int compileStage(unsigned int type, const std::string& code);
 };
@@ -0,0 +1,20 @@
+#include "ShaderDepthPyramid.h"
+
+
+ShaderDepthPyramid::ShaderDepthPyramid(const shared_ptr<GameObject>& parent)
+    : Shader("DepthPyramidShader.vert", "DepthPyramidShader.frag", parent) {}
+
+ShaderType ShaderDepthPyramid::getShaderType()
+{
+    return DepthPyramidShader;
+}
+
+void ShaderDepthPyramid::setPreviousLevel(const int texture, const int width, const int height, const bool firstLevel) const
+{
+    setInt("previousLevel", texture);
+    setIVec2("previousLevelSize", width, height);
+    setBool("firstLevel", firstLevel);
+}
+
+
+ShaderDepthPyramid::~ShaderDepthPyramid() = default;
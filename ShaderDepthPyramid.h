@@ -0,0 +1,10 @@
+#pragma once
+#include "Shader.h"
+
+class ShaderDepthPyramid : public Shader {
+public:
+    ShaderDepthPyramid(const shared_ptr<GameObject>& parent);
+    ShaderType getShaderType() override;
+    void setPreviousLevel(int texture, int width, int height, bool firstLevel) const;
+    ~ShaderDepthPyramid();
+};
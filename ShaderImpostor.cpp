@@ -0,0 +1,65 @@
+#include "ShaderImpostor.h"
+#include "OpenGLImports.h"
+#include "GameObject.h"
+#include "RenderView.h"
+#include "Light.h"
+#include "Transform.h"
+
+
+ShaderImpostor::ShaderImpostor(const shared_ptr<GameObject>& parent)
+    : Shader("Impostor.vert", "Impostor.frag", parent, "Impostor.geom") {}
+
+ShaderType ShaderImpostor::getShaderType()
+{
+    return ImpostorShader;
+}
+
+void ShaderImpostor::setupLighting(const list<shared_ptr<Light>>& illumination, const glm::vec4& emission) const
+{
+    // Directional lights only, the others have faded long before a mesh turns into an impostor
+    auto directionalLightCount = 0;
+    use();
+    for (const auto& light : illumination) {
+        if (light->lType != LIGHT_DIRECTIONAL) {
+            continue;
+        }
+        const auto posDirLight = std::to_string(directionalLightCount);
+        setVec3("dirLights[" + posDirLight + "].direction", light->getParent()->getTransform()->getPosition());
+        setVec3("dirLights[" + posDirLight + "].ambient", light->ambientColor);
+        setVec3("dirLights[" + posDirLight + "].diffuse", light->diffuseColor);
+        setFloat("dirLights[" + posDirLight + "].intensity", light->intensity);
+        ++directionalLightCount;
+    }
+    setInt("directionalLightCount", directionalLightCount);
+    setVec4("emissionColor", emission);
+}
+
+void ShaderImpostor::setup(const RenderView& view, const int colorAtlas, const int normalDepthAtlas) const
+{
+    use();
+    setInt("frames", constants::IMPOSTOR_FRAMES);
+    setInt("colorAtlas", colorAtlas);
+    setInt("normalDepthAtlas", normalDepthAtlas);
+    // Fragments behind the clipping plane are dropped even when the projection clips, baked depth moves them
+    const auto noPlane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    if (view.isMultiView()) {
+        setInt("layerCount", constants::MULTI_VIEW_COUNT);
+        for (auto layer = 0; layer < constants::MULTI_VIEW_COUNT; ++layer) {
+            const auto index = "[" + std::to_string(layer) + "]";
+            const auto layerView = view.getLayerViewMatrix(layer);
+            setMat4("views" + index, layerView);
+            setMat4("viewProjections" + index, view.getLayerViewProjectionMatrix(layer));
+            setVec3("viewPositions" + index, glm::vec3(glm::inverse(layerView)[3]));
+            setVec4("clippingPlanes" + index, view.getLayerClippingPlane(layer));
+        }
+    } else {
+        setInt("layerCount", 1);
+        setMat4("views[0]", view.getViewMatrix());
+        setMat4("viewProjections[0]", view.getViewProjectionMatrix());
+        setVec3("viewPositions[0]", view.getPosition());
+        setVec4("clippingPlanes[0]", view.hasClippingPlane() ? view.getClippingPlane() : noPlane);
+    }
+}
+
+
+ShaderImpostor::~ShaderImpostor() = default;
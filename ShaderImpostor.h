@@ -0,0 +1,15 @@
+#pragma once
+#include "Shader.h"
+#include <list>
+
+class Light;
+class RenderView;
+
+class ShaderImpostor : public Shader {
+public:
+    ShaderImpostor(const shared_ptr<GameObject>& parent);
+    ShaderType getShaderType() override;
+    void setupLighting(const list<shared_ptr<Light>>& illumination, const glm::vec4& emission) const;
+    void setup(const RenderView& view, int colorAtlas, int normalDepthAtlas) const;
+    ~ShaderImpostor();
+};
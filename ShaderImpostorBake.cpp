@@ -0,0 +1,35 @@
+#include "ShaderImpostorBake.h"
+#include "OpenGLImports.h"
+#include "Material.h"
+#include "Texture.h"
+
+
+ShaderImpostorBake::ShaderImpostorBake(const shared_ptr<GameObject>& parent)
+    : Shader("ImpostorBake.vert", "ImpostorBake.frag", parent) {}
+
+ShaderType ShaderImpostorBake::getShaderType()
+{
+    return ImpostorBakeShader;
+}
+
+void ShaderImpostorBake::setMaterial(const shared_ptr<Material>& material) const
+{
+    const auto hasDiffuseMap = material && material->diffuseMap;
+    setBool("hasDiffuseMap", hasDiffuseMap);
+    setInt("diffuseMap", constants::GENERIC_MATERIAL_GL_PLACE);
+    glActiveTexture(GL_TEXTURE0 + constants::GENERIC_MATERIAL_GL_PLACE);
+    glBindTexture(GL_TEXTURE_2D, hasDiffuseMap ? material->diffuseMap->getData() : 0);
+    setVec4("diffuseColor", material ? material->diffuse : glm::vec4(1.0f));
+}
+
+void ShaderImpostorBake::setFrame(const glm::mat4& viewProjection, const glm::vec3& boundsCenter, const float boundsRadius,
+                                  const glm::vec3& frameDirection) const
+{
+    setMat4("viewProjection", viewProjection);
+    setVec3("boundsCenter", boundsCenter);
+    setFloat("boundsRadius", boundsRadius);
+    setVec3("frameDirection", frameDirection);
+}
+
+
+ShaderImpostorBake::~ShaderImpostorBake() = default;
@@ -0,0 +1,14 @@
+#pragma once
+#include "Shader.h"
+
+class Material;
+
+class ShaderImpostorBake : public Shader {
+public:
+    ShaderImpostorBake(const shared_ptr<GameObject>& parent);
+    ShaderType getShaderType() override;
+    void setMaterial(const shared_ptr<Material>& material) const;
+    void setFrame(const glm::mat4& viewProjection, const glm::vec3& boundsCenter, float boundsRadius,
+                  const glm::vec3& frameDirection) const;
+    ~ShaderImpostorBake();
+};
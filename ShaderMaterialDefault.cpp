@@ -1,7 +1,7 @@
 #include "ShaderMaterialDefault.h"
 #include "OpenGLImports.h"
 #include "GameObject.h"
-#include "Camera.h"
+#include "RenderView.h"
 #include "Light.h"
 #include "Transform.h"
 #include "Material.h"
@@ -15,6 +15,8 @@ ShaderMaterialDefault::ShaderMaterialDefault(const shared_ptr<GameObject>& paren
     : Shader("DefaultMaterial.vert", "DefaultMaterial.frag", parent)
 {
     this->material = material;
+    singleViewID = ID;
+    multiViewID = compileProgram("DefaultMaterialMultiView.vert", "DefaultMaterial.frag", "DefaultMaterialMultiView.geom");
 }
 
 ShaderType ShaderMaterialDefault::getShaderType()
@@ -25,34 +27,44 @@ ShaderType ShaderMaterialDefault::getShaderType()
 
 ShaderMaterialDefault::~ShaderMaterialDefault() = default;
 
+void ShaderMaterialDefault::setMultiView(const bool enabled)
+{
+    ID = enabled ? multiViewID : singleViewID;
+}
+
+bool ShaderMaterialDefault::isMultiView() const
+{
+    return ID == multiViewID;
+}
+
 void ShaderMaterialDefault::setClippingPlane(const glm::vec4 plane) const
 {
     setVec4("clippingPlane", plane);
 }
 
 
-void ShaderMaterialDefault::setup(const shared_ptr<Material>& material, const shared_ptr<Mesh>& mesh) const
+void ShaderMaterialDefault::setup(const shared_ptr<Material>& material, const glm::mat4& model, const RenderView& view)
 {
-    if (!mesh) {
-        return;
-    }
-    const auto meshParent = mesh->getParent();
-    const auto transform = meshParent->getTransform();
-    const auto currentCamera = meshParent->currentCamera;
+    setMultiView(view.isMultiView());
     use();
     //******Camera Setup********
-    setVec3("viewPos", currentCamera->getPos());
-    const auto projection = glm::perspective(currentCamera->horizontalFOV, currentCamera->screenWidth / currentCamera->screenHeight, constants::NEAR_RENDER_PLANE, constants::FAR_RENDER_PLANE);
-    const auto view = currentCamera->getViewMatrix();
-    setMat4("projection", projection);
-    setMat4("view", view);
-    setMat4("model", glm::mat4());
+    if (view.isMultiView()) {
+        for (auto layer = 0; layer < constants::MULTI_VIEW_COUNT; ++layer) {
+            const auto index = "[" + std::to_string(layer) + "]";
+            setMat4("viewProjections" + index, view.getLayerViewProjectionMatrix(layer));
+            setVec4("clippingPlanes" + index, view.getLayerClippingPlane(layer));
+            setVec3("viewPositions" + index, glm::vec3(glm::inverse(view.getLayerViewMatrix(layer))[3]));
+        }
+    } else {
+        setVec3("viewPos", view.getPosition());
+        setMat4("projection", view.getProjectionMatrix());
+        setMat4("view", view.getViewMatrix());
+        if (view.usesClipDistance()) {
+            setClippingPlane(view.getClippingPlane());
+        }
+    }
     //**************************
 
-    glm::mat4 model;
-    model = translate(model, transform->getPosition());
-    model *= mat4_cast(transform->getRotation());
-    model = scale(model, transform->getScale());
     setMat4("model", model);
 }
 
@@ -151,6 +163,10 @@ void ShaderMaterialDefault::setupMaterial() const
 
 void ShaderMaterialDefault::objectMounted()
 {
-    setupLighting(); // STATIC LIGHTING, NO NEED TO UPDATE
-    setupMaterial(); // ONLY ONE MATERIAL, NO NEED TO UPDATE, JUST INITIALIZE ONCE
+    // Both programs keep their own uniform state
+    for (const auto program : { multiViewID, singleViewID }) {
+        ID = program;
+        setupLighting(); // STATIC LIGHTING, NO NEED TO UPDATE
+        setupMaterial(); // ONLY ONE MATERIAL, NO NEED TO UPDATE, JUST INITIALIZE ONCE
+    }
 }
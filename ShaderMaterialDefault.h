@@ -2,16 +2,23 @@
 #include "Shader.h"
 
 class Material;
+class RenderView;
 
 class ShaderMaterialDefault : public Shader {
 public:
     ShaderMaterialDefault(const shared_ptr<GameObject>& parent, const shared_ptr<Material>& material);
     ShaderType getShaderType() override;
     ~ShaderMaterialDefault();
-    void setup(const shared_ptr<Material>& material, const shared_ptr<Mesh>& mesh) const;
+    void setup(const shared_ptr<Material>& material, const glm::mat4& model, const RenderView& view);
     void setupLighting() const;
     void setupMaterial() const;
     void objectMounted() override;
     void setClippingPlane(glm::vec4 plane) const;
+    void setMultiView(bool enabled);
+    bool isMultiView() const;
     shared_ptr<Material> material;
+
+private:
+    unsigned int singleViewID;
+    unsigned int multiViewID;
 };
@@ -1,17 +1,29 @@
 #include "ShaderWater.h"
 #include "GameObject.h"
-#include "Camera.h"
+#include "RenderView.h"
 #include "Transform.h"
 #include "Mesh.h"
 #include "Texture.h"
+#include "EngineClock.h"
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 
 
 ShaderWater::ShaderWater(const shared_ptr<GameObject>& parent)
     : Shader("WaterShader.vert", "WaterShader.frag", parent)
 {
-    moveFactor = 0;
+    moveFactor = 0.0f;
     waterDistortionTexture = make_unique<Texture>("waterDuDvMap.png", true);
+
+    // Samplers of different types may not share a unit, even unused ones, so every one gets its own up front
+    use();
+    setInt("reflectionTexture", constants::REFLECTION_MAP_GL_PLACE);
+    setInt("refractionTexture", constants::REFRACTION_MAP_GL_PLACE);
+    setInt("multiViewTexture", constants::MULTI_VIEW_MAP_GL_PLACE);
+    setInt("sceneColorTexture", constants::SCENE_COLOR_MAP_GL_PLACE);
+    setInt("sceneDepthTexture", constants::SCENE_DEPTH_MAP_GL_PLACE);
+    setInt("depthPyramid", constants::DEPTH_PYRAMID_GL_PLACE);
+    setInt("skybox", constants::SKYBOX_MAP_GL_PLACE);
 }
 
 ComponentKey ShaderWater::getComponentKey()
@@ -24,27 +36,19 @@ ShaderType ShaderWater::getShaderType()
     return WaterShader;
 }
 
-void ShaderWater::setup(Mesh* mesh) const
+void ShaderWater::setup(const glm::mat4& model, const RenderView& view) const
 {
     use();
-    const auto meshParent = mesh->getParent();
-    const auto transform = meshParent->getTransform();
-    const auto currentCamera = meshParent->currentCamera;
-    const auto projection = glm::perspective(currentCamera->horizontalFOV, currentCamera->screenWidth / currentCamera->screenHeight, constants::NEAR_RENDER_PLANE, constants::FAR_RENDER_PLANE);
-    const auto view = currentCamera->getViewMatrix();
-    setMat4("matrixViewProjection", projection * view);
-    glm::mat4 model;
-    model = translate(model, transform->getPosition());
-    model *= mat4_cast(transform->getRotation());
-    model = scale(model, transform->getScale());
+    setMat4("matrixViewProjection", view.getViewProjectionMatrix());
+    setMat4("view", view.getViewMatrix());
+    setMat4("projection", view.getProjectionMatrix());
     setMat4("model", model);
 
     glActiveTexture(GL_TEXTURE0 + constants::WATER_DISTORTION_MAP_GL_PLACE);
     glBindTexture(GL_TEXTURE_2D, waterDistortionTexture->getData());
     setInt("waterDistortionMap", constants::WATER_DISTORTION_MAP_GL_PLACE);
 
-    setFloat("moveFactor", static_cast<float>(moveFactor / 1200.0f));
-    setVec3("viewPosition", currentCamera->getPos());
+    setVec3("viewPosition", view.getPosition());
 }
 
 void ShaderWater::addReflectionTexture(const int texture) const
@@ -57,10 +61,59 @@ void ShaderWater::addRefractionTexture(const int texture) const
     setInt("refractionTexture", texture);
 }
 
+void ShaderWater::addMultiViewTexture(const int texture) const
+{
+    setBool("multiView", texture >= 0);
+    if (texture >= 0) {
+        setInt("multiViewTexture", texture);
+    }
+}
+
+void ShaderWater::addSceneTextures(const int colorTexture, const int depthTexture) const
+{
+    setBool("screenSpaceRefraction", colorTexture >= 0);
+    if (colorTexture >= 0) {
+        setInt("sceneColorTexture", colorTexture);
+        setInt("sceneDepthTexture", depthTexture);
+    }
+}
+
+void ShaderWater::addScreenSpaceReflection(const int depthPyramid, const int depthPyramidLevels, const int skybox) const
+{
+    setBool("screenSpaceReflection", depthPyramid >= 0);
+    if (depthPyramid >= 0) {
+        setInt("depthPyramid", depthPyramid);
+        setInt("depthPyramidLevels", depthPyramidLevels);
+        setBool("skyboxFallback", skybox >= 0);
+        if (skybox >= 0) {
+            setInt("skybox", skybox);
+        }
+    }
+}
+
+// The render thread takes the value from its SceneSnapshot, update may already be advancing the next one
+void ShaderWater::addMoveFactor(const float moveFactor) const
+{
+    setFloat("moveFactor", moveFactor);
+}
+
+float ShaderWater::getMoveFactor() const
+{
+    return moveFactor;
+}
+
 void ShaderWater::update()
 {
-    moveFactor += 1;
-    moveFactor %= 1200;
+    // Every water object using this shader updates it, so the phase follows simulation time instead of
+    // accumulating steps and the repeats leave it unchanged
+    const auto phase = parent->engineClock->getSimulationTime() / constants::WATER_WAVE_PERIOD;
+    moveFactor = static_cast<float>(phase - std::floor(phase));
+}
+
+vector<shared_ptr<GameObject>> ShaderWater::getUpdateDependencies()
+{
+    // One instance is shared by every water object, moveFactor lives with the parent
+    return { parent };
 }
 
 
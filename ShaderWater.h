@@ -4,18 +4,25 @@
 class Texture;
 
 class Mesh;
+class RenderView;
 
 class ShaderWater : public Shader {
 public:
     ShaderWater(const shared_ptr<GameObject>& parent);
     ComponentKey getComponentKey() override;
     ShaderType getShaderType() override;
-    void setup(Mesh* mesh) const;
+    void setup(const glm::mat4& model, const RenderView& view) const;
     void addReflectionTexture(int texture) const;
     void addRefractionTexture(int texture) const;
+    void addMultiViewTexture(int texture) const;
+    void addSceneTextures(int colorTexture, int depthTexture) const;
+    void addScreenSpaceReflection(int depthPyramid, int depthPyramidLevels, int skybox) const;
+    void addMoveFactor(float moveFactor) const;
+    float getMoveFactor() const;
     void update() override;
+    vector<shared_ptr<GameObject>> getUpdateDependencies() override;
     ~ShaderWater();
 private:
     unique_ptr<Texture> waterDistortionTexture;
-    int moveFactor;
+    float moveFactor; // scroll phase of the distortion, 0 to 1
 };
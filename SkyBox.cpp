@@ -2,15 +2,15 @@
 #include "OpenGLImports.h"
 #include "Texture.h"
 #include "ShaderMaterialSkyBox.h"
-#include "Camera.h"
+#include "RenderView.h"
 #include "GameObject.h"
 #include <glm/gtc/matrix_transform.hpp>
 
 
-SkyBox::SkyBox(const std::vector<std::string>& faces, const shared_ptr<GameObject>& parent)
+SkyBox::SkyBox(const shared_ptr<Texture>& texture, const shared_ptr<GameObject>& parent)
     : Component("sky_box", parent)
 {
-    this->texture = make_shared<Texture>(faces);
+    this->texture = texture;
     setupMesh();
 }
 
@@ -82,9 +82,8 @@ void SkyBox::setupMesh()
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), static_cast<void*>(nullptr));
 }
 
-void SkyBox::lateRender()
+void SkyBox::lateRender(const RenderView& view)
 {
-    const auto currentCamera = parent->currentCamera;
     const auto shaderSkyBox = parent->getComponentFirst(ShaderComponent);
     if (shaderSkyBox) {
         const auto shader = static_pointer_cast<ShaderMaterialSkyBox>(shaderSkyBox);
@@ -98,10 +97,10 @@ void SkyBox::lateRender()
 
         shader->use();
         //******Camera Setup********
-        const auto projection = glm::perspective(currentCamera->horizontalFOV, currentCamera->screenWidth / currentCamera->screenHeight, constants::NEAR_RENDER_PLANE, constants::FAR_RENDER_PLANE);
-        const auto view = glm::mat4(glm::mat3(currentCamera->getViewMatrix()));
-        shader->setMat4("projection", projection);
-        shader->setMat4("view", view);
+        // Layered water pass: only the reflection layer (layer 0, the default for non layered programs) shows the sky
+        const auto cameraView = view.isMultiView() ? view.getLayerViewMatrix(constants::MULTI_VIEW_REFLECTION_LAYER) : view.getViewMatrix();
+        shader->setMat4("projection", view.getProjectionMatrix());
+        shader->setMat4("view", glm::mat4(glm::mat3(cameraView)));
         //**************************
 
         //******Texture Setup*******
@@ -117,3 +116,10 @@ void SkyBox::lateRender()
         glDepthFunc(oldDepthFuncMode);
     }
 }
+
+int SkyBox::bindTexture(const int place) const
+{
+    glActiveTexture(GL_TEXTURE0 + place);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, texture->getData());
+    return place;
+}
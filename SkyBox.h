@@ -1,17 +1,16 @@
 #pragma once
 #include "Component.h"
-#include <vector>
-#include <string>
 
 class Texture;
 
 class SkyBox : public Component {
 public:
-    SkyBox(const std::vector<std::string>& faces, const shared_ptr<GameObject>& parent);
+    SkyBox(const shared_ptr<Texture>& texture, const shared_ptr<GameObject>& parent);
     ComponentKey getComponentKey() override;
     ~SkyBox();
     void setupMesh();
-    void lateRender() override;
+    void lateRender(const RenderView& view) override;
+    int bindTexture(int place) const;
 private:
     shared_ptr<Texture> texture;
     unsigned int vao;
@@ -2,68 +2,141 @@
 #include "OpenGLImports.h"
 #include "FreeImage.h"
 
-Texture::Texture(const string& path, const bool repeat)
+namespace {
+    // Takes ownership of bitmap
+    bool readBitmap(FIBITMAP* bitmap, Texture::Image& image, const bool flipVertical)
+    {
+        if (bitmap == nullptr) {
+            return false;
+        }
+        const auto converted = FreeImage_ConvertTo24Bits(bitmap);
+        FreeImage_Unload(bitmap);
+        if (converted == nullptr) {
+            return false;
+        }
+        if (flipVertical) {
+            FreeImage_FlipVertical(converted);
+        }
+        image.width = FreeImage_GetWidth(converted);
+        image.height = FreeImage_GetHeight(converted);
+        // FreeImage pads its rows to 4 bytes too, the bits go to GL as they are
+        const auto bits = FreeImage_GetBits(converted);
+        image.pixels.assign(bits, bits + static_cast<size_t>(FreeImage_GetPitch(converted)) * image.height);
+        FreeImage_Unload(converted);
+        return true;
+    }
+}
+
+bool Texture::decode(const string& path, Image& image, const bool flipVertical)
 {
-    texture = 0;
     const auto fif = FreeImage_GetFIFFromFilename(path.c_str());
-    auto bitmap = FreeImage_Load(fif, path.c_str());
-    bitmap = FreeImage_ConvertTo24Bits(bitmap);
-    const auto w = FreeImage_GetWidth(bitmap);
-    const auto h = FreeImage_GetHeight(bitmap);
-    void* data = FreeImage_GetBits(bitmap);
-
-    glEnable(GL_TEXTURE_2D);
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w, h, 0, GL_BGR_EXT, GL_UNSIGNED_BYTE, data);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, repeat ? GL_REPEAT : GL_CLAMP);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, repeat ? GL_REPEAT : GL_CLAMP);
+    return readBitmap(FreeImage_Load(fif, path.c_str()), image, flipVertical);
+}
 
-    glBindTexture(GL_TEXTURE_2D, NULL);
+bool Texture::decode(const void* file, const size_t size, Image& image)
+{
+    // FreeImage only reads from the buffer, it just isn't declared const
+    const auto memory = FreeImage_OpenMemory(static_cast<BYTE*>(const_cast<void*>(file)), static_cast<DWORD>(size));
+    const auto fif = FreeImage_GetFileTypeFromMemory(memory, 0);
+    const auto bitmap = FreeImage_LoadFromMemory(fif, memory, 0);
+    FreeImage_CloseMemory(memory);
+    return readBitmap(bitmap, image, false);
+}
 
+Texture::Texture(const string& path, const bool repeat)
+{
+    texture = 0;
+    create(false, repeat);
+    Image image;
+    if (decode(path, image)) {
+        setImage(0, image.width, image.height, image.pixels.data());
+    }
     error = glGetError();
+}
 
-    FreeImage_Unload(bitmap);
+Texture::Texture(const void* file, const size_t size, const bool repeat)
+{
+    texture = 0;
+    create(false, repeat);
+    Image image;
+    if (decode(file, size, image)) {
+        setImage(0, image.width, image.height, image.pixels.data());
+    }
+    error = glGetError();
 }
 
 Texture::Texture(vector<string> faces)
 {
+    texture = 0;
+    create(true, false);
+    for (unsigned int i = 0; i < faces.size(); i++) {
+        Image image;
+        if (decode(faces[i], image, true)) {
+            setImage(i, image.width, image.height, image.pixels.data());
+        }
+    }
     error = glGetError();
+}
+
+Texture::Texture(const Target target, const bool repeat)
+{
     texture = 0;
+    create(target == Target::CubeMap, repeat);
+    error = glGetError();
+}
 
+void Texture::create(const bool cubeMap, const bool repeat)
+{
+    this->cubeMap = cubeMap;
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+    if (cubeMap) {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    } else {
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, repeat ? GL_REPEAT : GL_CLAMP);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, repeat ? GL_REPEAT : GL_CLAMP);
+        glBindTexture(GL_TEXTURE_2D, NULL);
+    }
 
-    for (unsigned int i = 0; i < faces.size(); i++) {
-        const auto fif = FreeImage_GetFIFFromFilename(faces[i].c_str());
-        auto bitmap = FreeImage_Load(fif, faces[i].c_str());
-        bitmap = FreeImage_ConvertTo24Bits(bitmap);
-        FreeImage_FlipVertical(bitmap);
-        const auto w = FreeImage_GetWidth(bitmap);
-        const auto h = FreeImage_GetHeight(bitmap);
-        void* data = FreeImage_GetBits(bitmap);
-        if (data) {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                         0,
-                         GL_RGB,
-                         w,
-                         h,
-                         0,
-                         GL_BGR_EXT,
-                         GL_UNSIGNED_BYTE,
-                         data
-                );
-            FreeImage_Unload(bitmap);
-        }
+    // Complete from the start, so it can be bound and sampled before its image arrives
+    const unsigned char grey[4] = { 128, 128, 128, 0 };
+    for (auto face = 0u; face < (cubeMap ? 6u : 1u); ++face) {
+        setImage(face, 1, 1, grey);
+    }
+}
+
+void Texture::setImage(const unsigned int face, const unsigned int width, const unsigned int height, const void* data)
+{
+    const auto target = cubeMap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    glBindTexture(target, texture);
+    glTexImage2D(cubeMap ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_BGR_EXT,
+                 GL_UNSIGNED_BYTE, data);
+    glBindTexture(target, 0);
+    faceBytes[face] = static_cast<size_t>(width) * height * 4;
+}
+
+bool Texture::isCubeMap() const
+{
+    return cubeMap;
+}
+
+size_t Texture::getMemorySize() const
+{
+    size_t memory = 0;
+    for (const auto bytes : faceBytes) {
+        memory += bytes;
     }
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    return memory;
 }
 
 unsigned int Texture::getData() const
@@ -5,11 +5,37 @@ using namespace std;
 
 class Texture {
 public:
+    enum class Target { Texture2D, CubeMap };
+
+    // Decoded pixels, 24 bit BGR rows padded to 4 bytes the way GL unpacks them by default
+    struct Image {
+        unsigned int width = 0;
+        unsigned int height = 0;
+        vector<unsigned char> pixels;
+    };
+
+    // Decoding needs no GL context, any thread may run it. False when the file can't be read.
+    static bool decode(const string& path, Image& image, bool flipVertical = false);
+    static bool decode(const void* file, size_t size, Image& image);
+
     Texture(const string& path, bool repeat = false);
     Texture(vector<string> faces);
+    // Decodes an image file already in memory, the format is detected from its contents
+    Texture(const void* file, size_t size, bool repeat = false);
+    // A 1x1 grey stand in until setImage gives it its pixels, with the name it will keep
+    Texture(Target target, bool repeat);
+    // face is the cube map face, 0 for 2D textures. With a pixel unpack buffer bound data is an offset into it.
+    void setImage(unsigned int face, unsigned int width, unsigned int height, const void* data);
+    bool isCubeMap() const;
+    // Estimated GPU memory of the images set so far, drivers keep RGB texels in 4 bytes
+    size_t getMemorySize() const;
     unsigned int getData() const;
     virtual ~Texture();
     int error;
 private:
+    void create(bool cubeMap, bool repeat);
+
     unsigned int texture;
+    bool cubeMap = false;
+    size_t faceBytes[6] = {};
 };
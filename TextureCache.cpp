@@ -0,0 +1,159 @@
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <cctype>
+#include <tuple>
+
+TextureCache::TextureCache(TextureStreamer* streamer)
+    : streamer(streamer) {}
+
+bool TextureCache::Key::operator<(const Key& other) const
+{
+    return std::tie(path, repeat, cubeMap) < std::tie(other.path, other.repeat, other.cubeMap);
+}
+
+string TextureCache::normalizePath(const string& path)
+{
+    vector<string> parts;
+    string part;
+    const auto absolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+    for (size_t i = 0; i <= path.size(); ++i) {
+        const auto c = i < path.size() ? path[i] : '/';
+        if (c != '/' && c != '\\') {
+            part += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            continue;
+        }
+        if (part == ".." && !parts.empty() && parts.back() != "..") {
+            parts.pop_back();
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        part.clear();
+    }
+    string normalized = absolute ? "/" : "";
+    for (size_t i = 0; i < parts.size(); ++i) {
+        normalized += (i > 0 ? "/" : "") + parts[i];
+    }
+    return normalized;
+}
+
+shared_ptr<Texture> TextureCache::find(const Key& key)
+{
+    const auto entry = entries.find(key);
+    if (entry == entries.end()) {
+        ++misses;
+        return nullptr;
+    }
+    ++hits;
+    entry->second.lastUse = ++useCounter;
+    return entry->second.texture;
+}
+
+shared_ptr<Texture> TextureCache::insert(const Key& key, const shared_ptr<Texture>& texture)
+{
+    entries[key] = Entry{ texture, ++useCounter };
+    return texture;
+}
+
+shared_ptr<Texture> TextureCache::load(const string& path, const bool repeat)
+{
+    const Key key{ normalizePath(path), repeat, false };
+    if (const auto cached = find(key)) {
+        return cached;
+    }
+    if (streamer == nullptr) {
+        return insert(key, make_shared<Texture>(path, repeat));
+    }
+    const auto texture = make_shared<Texture>(Texture::Target::Texture2D, repeat);
+    streamer->request(texture, 0, [path](Texture::Image& image) {
+        return Texture::decode(path, image);
+    });
+    return insert(key, texture);
+}
+
+shared_ptr<Texture> TextureCache::load(const string& path, const void* file, const size_t size, const bool repeat)
+{
+    const Key key{ normalizePath(path), repeat, false };
+    if (const auto cached = find(key)) {
+        return cached;
+    }
+    if (streamer == nullptr) {
+        return insert(key, make_shared<Texture>(file, size, repeat));
+    }
+    const auto texture = make_shared<Texture>(Texture::Target::Texture2D, repeat);
+    streamer->request(texture, 0, [file, size](Texture::Image& image) {
+        return Texture::decode(file, size, image);
+    });
+    return insert(key, texture);
+}
+
+shared_ptr<Texture> TextureCache::loadCubeMap(const vector<string>& faces)
+{
+    Key key{ "", false, true };
+    for (const auto& face : faces) {
+        key.path += (key.path.empty() ? "" : "|") + normalizePath(face);
+    }
+    if (const auto cached = find(key)) {
+        return cached;
+    }
+    if (streamer == nullptr) {
+        return insert(key, make_shared<Texture>(faces));
+    }
+    // The faces decode side by side
+    const auto texture = make_shared<Texture>(Texture::Target::CubeMap, false);
+    for (auto face = 0u; face < faces.size(); ++face) {
+        const auto path = faces[face];
+        streamer->request(texture, face, [path](Texture::Image& image) {
+            return Texture::decode(path, image, true);
+        });
+    }
+    return insert(key, texture);
+}
+
+void TextureCache::trim(const size_t budget)
+{
+    auto memory = getMemorySize();
+    if (memory <= budget) {
+        return;
+    }
+    vector<std::map<Key, Entry>::iterator> unused;
+    for (auto entry = entries.begin(); entry != entries.end(); ++entry) {
+        if (entry->second.texture.use_count() == 1) {
+            unused.push_back(entry);
+        }
+    }
+    std::sort(unused.begin(), unused.end(), [](const std::map<Key, Entry>::iterator& a, const std::map<Key, Entry>::iterator& b) {
+        return a->second.lastUse < b->second.lastUse;
+    });
+    for (const auto& entry : unused) {
+        if (memory <= budget) {
+            break;
+        }
+        memory -= entry->second.texture->getMemorySize();
+        entries.erase(entry);
+    }
+}
+
+size_t TextureCache::getCount() const
+{
+    return entries.size();
+}
+
+size_t TextureCache::getMemorySize() const
+{
+    size_t memory = 0;
+    for (const auto& entry : entries) {
+        memory += entry.second.texture->getMemorySize();
+    }
+    return memory;
+}
+
+int TextureCache::getHitCount() const
+{
+    return hits;
+}
+
+int TextureCache::getMissCount() const
+{
+    return misses;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "Texture.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TextureStreamer;
+
+// One texture per image, however many materials or scenes ask for it. Entries are keyed by the normalized
+// path and the sampler settings, and handed out as shared handles; the cache keeps its own reference, so an
+// image stays loaded between scenes until trim finds nothing else holding it.
+class TextureCache {
+public:
+    // With a streamer new textures start as placeholders and stream in, without one they load on the spot
+    explicit TextureCache(TextureStreamer* streamer = nullptr);
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    shared_ptr<Texture> load(const string& path, bool repeat = false);
+    // Decodes from a copy of the file at path already in memory, which has to outlive the streaming
+    shared_ptr<Texture> load(const string& path, const void* file, size_t size, bool repeat = false);
+    shared_ptr<Texture> loadCubeMap(const vector<string>& faces);
+    // Drops the textures only the cache holds, least recently requested first, until at most budget bytes
+    // of textures remain
+    void trim(size_t budget = 0);
+
+    size_t getCount() const;
+    size_t getMemorySize() const; // estimated GPU bytes of everything cached
+    int getHitCount() const;
+    int getMissCount() const;
+    // Separators unified, . and .. resolved and case folded the way Windows compares paths
+    static string normalizePath(const string& path);
+
+private:
+    struct Key {
+        string path; // the faces joined by | for cube maps
+        bool repeat;
+        bool cubeMap;
+        bool operator<(const Key& other) const;
+    };
+
+    struct Entry {
+        shared_ptr<Texture> texture;
+        unsigned long long lastUse;
+    };
+
+    // The cached texture for key, marked as used, or null
+    shared_ptr<Texture> find(const Key& key);
+    shared_ptr<Texture> insert(const Key& key, const shared_ptr<Texture>& texture);
+
+    TextureStreamer* streamer;
+    std::map<Key, Entry> entries;
+    unsigned long long useCounter = 0;
+    int hits = 0;
+    int misses = 0;
+};
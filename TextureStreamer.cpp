@@ -0,0 +1,145 @@
+#include "TextureStreamer.h"
+#include "Constants.h"
+#include "EngineClock.h"
+#include "OpenGLImports.h"
+#include <algorithm>
+#include <cstring>
+
+TextureStreamer::TextureStreamer(JobSystem& decodeJobs)
+    : decodeJobs(decodeJobs) {}
+
+TextureStreamer::~TextureStreamer()
+{
+    // The jobs write into the requests
+    decodeJobs.wait(decodeGroup);
+    for (const auto& request : requests) {
+        if (request->pixelBuffer != 0) {
+            glDeleteBuffers(1, &request->pixelBuffer);
+        }
+    }
+}
+
+void TextureStreamer::request(const std::shared_ptr<Texture>& texture, const unsigned int face, const Decode& decode)
+{
+    auto request = std::make_unique<Request>();
+    request->texture = texture;
+    request->face = face;
+    request->decode = decode;
+    const auto pending = request.get();
+    requests.push_back(std::move(request));
+    decodeJobs.run(decodeGroup, [pending] {
+        const auto start = EngineClock::now();
+        pending->decoded = pending->decode(pending->image);
+        pending->decodeSeconds = EngineClock::now() - start;
+        pending->done.store(true, std::memory_order_release);
+    });
+}
+
+TextureStreamer::Request* TextureStreamer::nextDecoded()
+{
+    for (auto it = requests.begin(); it != requests.end();) {
+        const auto request = it->get();
+        if (!request->done.load(std::memory_order_acquire)) {
+            ++it;
+            continue;
+        }
+        if (request->decoded && !request->image.pixels.empty()) {
+            return request;
+        }
+        // Keeps its placeholder, the way a missing file kept an empty texture before
+        decodeSeconds += request->decodeSeconds;
+        it = requests.erase(it);
+    }
+    return nullptr;
+}
+
+void TextureStreamer::update()
+{
+    if (requests.empty()) {
+        return;
+    }
+    if (decodeJobs.getWorkerCount() == 0) {
+        // Nothing else would run the decodes
+        decodeJobs.wait(decodeGroup);
+    }
+    auto budget = static_cast<size_t>(constants::TEXTURE_UPLOAD_BUDGET);
+    auto uploaded = false;
+    while (budget > 0) {
+        if (uploading == nullptr) {
+            uploading = nextDecoded();
+            if (uploading == nullptr) {
+                break;
+            }
+            glGenBuffers(1, &uploading->pixelBuffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploading->pixelBuffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, uploading->image.pixels.size(), nullptr, GL_STREAM_DRAW);
+        } else {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploading->pixelBuffer);
+        }
+        if (uploadStart < 0.0) {
+            uploadStart = EngineClock::now();
+        }
+        // The range was never handed to GL, nothing to synchronize with
+        const auto& pixels = uploading->image.pixels;
+        const auto slice = std::min(budget, pixels.size() - uploading->copied);
+        const auto mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, uploading->copied, slice,
+                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (mapped != nullptr) {
+            memcpy(mapped, pixels.data() + uploading->copied, slice);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        uploading->copied += slice;
+        budget -= slice;
+        uploadedBytes += slice;
+        uploaded = true;
+        if (uploading->copied == pixels.size()) {
+            finish(uploading);
+            uploading = nullptr;
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (uploaded) {
+        ++uploadFrames;
+        uploadEnd = EngineClock::now();
+    }
+}
+
+void TextureStreamer::finish(Request* request)
+{
+    // Offset 0 into the bound buffer, GL keeps the buffer alive until the transfer is done
+    request->texture->setImage(request->face, request->image.width, request->image.height, nullptr);
+    glDeleteBuffers(1, &request->pixelBuffer);
+    decodeSeconds += request->decodeSeconds;
+    ++textureCount;
+    requests.remove_if([request](const std::unique_ptr<Request>& pending) { return pending.get() == request; });
+}
+
+bool TextureStreamer::isIdle() const
+{
+    return requests.empty();
+}
+
+double TextureStreamer::getDecodeSeconds() const
+{
+    return decodeSeconds;
+}
+
+double TextureStreamer::getUploadSeconds() const
+{
+    return uploadStart < 0.0 ? 0.0 : uploadEnd - uploadStart;
+}
+
+int TextureStreamer::getUploadFrames() const
+{
+    return uploadFrames;
+}
+
+size_t TextureStreamer::getUploadedBytes() const
+{
+    return uploadedBytes;
+}
+
+int TextureStreamer::getTextureCount() const
+{
+    return textureCount;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "Texture.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+
+// Fills textures in without stalling a frame. Each request decodes on the loading pool while the texture is
+// bound as its 1x1 placeholder, then update, once a frame on the GL thread, copies at most
+// TEXTURE_UPLOAD_BUDGET bytes of decoded pixels into a pixel unpack buffer. A full buffer becomes the
+// texture's image, GL reads it from there on its own time instead of the frame waiting on the copy.
+class TextureStreamer {
+public:
+    using Decode = std::function<bool(Texture::Image& image)>;
+
+    explicit TextureStreamer(JobSystem& decodeJobs);
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+    ~TextureStreamer();
+
+    // GL thread. decode runs on a worker, so whatever it reads must stay valid until the streamer is idle.
+    void request(const std::shared_ptr<Texture>& texture, unsigned int face, const Decode& decode);
+    void update();
+    bool isIdle() const;
+
+    // Over everything streamed so far
+    double getDecodeSeconds() const; // summed over the workers
+    double getUploadSeconds() const; // first slice to last
+    int getUploadFrames() const;
+    size_t getUploadedBytes() const;
+    int getTextureCount() const;
+
+private:
+    struct Request {
+        std::shared_ptr<Texture> texture;
+        unsigned int face = 0;
+        Decode decode;
+        Texture::Image image;
+        bool decoded = false; // with decodeSeconds, written by the worker before done is set
+        double decodeSeconds = 0.0;
+        std::atomic<bool> done{ false };
+        unsigned int pixelBuffer = 0;
+        size_t copied = 0;
+    };
+
+    // The first request whose pixels are ready, failed ones are dropped on the way
+    Request* nextDecoded();
+    void finish(Request* request);
+
+    JobSystem& decodeJobs;
+    JobSystem::JobGroup decodeGroup;
+    std::list<std::unique_ptr<Request>> requests; // in request order, until uploaded or failed
+    Request* uploading = nullptr;
+    double decodeSeconds = 0.0;
+    double uploadStart = -1.0;
+    double uploadEnd = 0.0;
+    int uploadFrames = 0;
+    size_t uploadedBytes = 0;
+    int textureCount = 0;
+};
@@ -1,6 +1,7 @@
 #include "Transform.h"
 #include "GameObject.h"
 #include "Mesh.h"
+#include <glm/gtc/matrix_transform.hpp>
 
 Transform::Transform(const shared_ptr<GameObject>& parent)
     : Component("transform", parent) {}
@@ -126,6 +127,15 @@ glm::vec3 Transform::getScale() const
     return scale;
 }
 
+glm::mat4 Transform::getModelMatrix() const
+{
+    glm::mat4 model;
+    model = translate(model, position);
+    model *= mat4_cast(rotation);
+    model = glm::scale(model, scale);
+    return model;
+}
+
 glm::vec3 Transform::getLocalPosition() const
 {
     const auto parentParent = parent->getParent();
@@ -23,6 +23,7 @@ public:
     glm::vec3 getPosition() const;
     glm::quat getRotation() const;
     glm::vec3 getScale() const;
+    glm::mat4 getModelMatrix() const;
     glm::vec3 getLocalPosition() const;
     glm::quat getLocalRotation() const;
     glm::vec3 getLocalScale() const;
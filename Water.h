@@ -1,34 +1,21 @@
 #pragma once
 #include "GameObject.h"
+#include "WaterModes.h"
+#include <glm/glm.hpp>
 
+class RenderView;
+
+// The reflection and refraction targets are transient render graph resources, shared between water bodies
 class Water : public GameObject {
 public:
     Water(const string& name, const shared_ptr<GameObject>& parent = nullptr);
     ~Water();
 
-    void setupRefraction() const;
-    void endRefraction();
-    void setupReflection() const;
-    void endReflection();
-
     int refractionMapOpenGlBind;
     int reflectionMapOpenGlBind;
 
-    unsigned int getReflectionTexture() const;
-    unsigned int getRefractionTexture() const;
-    unsigned int getRefractionDepthTexture() const;
-
-    int bindReflectionTexture() const;
-    int bindRefractionTexture() const;
-
-    void renderWater();
-
-private:
-    unsigned int refractionFrameBuffer;
-    unsigned int refractionTexture;
-    unsigned int refractionDepthTexture;
+    void renderWater(const RenderView& view, const glm::mat4& model);
+    bool isVisible(const RenderView& view, const glm::mat4& model);
 
-    unsigned int reflectionFrameBuffer;
-    unsigned int reflectionTexture;
-    unsigned int reflectionDepthBuffer;
+    WaterModes modes;
 };
@@ -0,0 +1,20 @@
+#pragma once
+
+enum WaterRefractionMode {
+    PlanarRefraction = 0, // re-renders the scene below the water plane
+    ScreenSpaceRefraction // samples the main pass color and depth
+};
+
+enum WaterReflectionMode {
+    PlanarReflection = 0, // re-renders the scene mirrored about the water plane
+    ScreenSpaceReflection // ray-marches the main pass depth, falling back to the skybox
+};
+
+// How a water body renders what it reflects and refracts. A scene sets them per water node through the node's
+// metadata, the command line can force them on every water body and keys toggle them while running.
+struct WaterModes {
+    bool obliqueClipping = false; // the projection's near plane clips instead of a clip distance
+    bool multiView = true; // both planar views in one layered pass, where the GL version allows
+    WaterRefractionMode refractionMode = PlanarRefraction;
+    WaterReflectionMode reflectionMode = PlanarReflection;
+};
@@ -4,15 +4,98 @@ out vec4 FragColor;
 in vec4 clipSpace;
 in vec2 TexCoords;
 in vec3 toCameraVector;
+in vec3 worldPosition;
 
 uniform sampler2D reflectionTexture;
 uniform sampler2D refractionTexture;
 uniform sampler2D waterDistortionMap;
+// reflection in layer 0 and refraction in layer 1 when both were rendered in one layered pass
+uniform sampler2DArray multiViewTexture;
+uniform bool multiView;
+// copy of the main pass, used instead of refractionTexture for screen space refraction
+uniform sampler2D sceneColorTexture;
+uniform sampler2D sceneDepthTexture;
+uniform bool screenSpaceRefraction;
+// min depth mip chain of sceneDepthTexture, ray-marched instead of rendering reflectionTexture
+uniform sampler2D depthPyramid;
+uniform int depthPyramidLevels;
+uniform samplerCube skybox;
+uniform bool skyboxFallback;
+uniform bool screenSpaceReflection;
+uniform mat4 view;
+uniform mat4 projection;
 
 const float waveStrength = 0.005;
+const float reflectionNormalStrength = 20.0;
+const int maxTraceIterations = 64;
+const float maxTraceDistance = 2000.0;
+const float hitThickness = 2.0;
 
 uniform float moveFactor;
 
+// view space distance from a [0, 1] window depth, for the matrices built by glm::perspective
+float linearDepth(float depth)
+{
+	return projection[3][2] / ((depth * 2.0 - 1.0) + projection[2][2]);
+}
+
+vec3 toScreen(vec3 viewPosition)
+{
+	vec4 clip = projection * vec4(viewPosition, 1.0);
+	return (clip.xyz / clip.w) * 0.5 + 0.5;
+}
+
+// Hierarchical-Z trace in (uv, window depth) space, where the ray is a straight line.
+// Returns the hit uv in xy and a confidence in z (0 on a miss).
+vec3 traceScreenSpaceRay(vec3 origin, vec3 direction)
+{
+	// keep the end point in front of the near plane, rays towards the camera get shortened
+	float rayLength = maxTraceDistance;
+	float nearPlane = projection[3][2] / (projection[2][2] - 1.0);
+	if (direction.z > 0.0) {
+		rayLength = min(rayLength, (-nearPlane - origin.z) / direction.z * 0.99);
+	}
+	vec3 rayStart = toScreen(origin);
+	vec3 rayDirection = toScreen(origin + direction * rayLength) - rayStart;
+	vec2 directionSign = step(0.0, rayDirection.xy);
+	vec2 inverseDirection = 1.0 / mix(min(rayDirection.xy, vec2(-1e-6)), max(rayDirection.xy, vec2(1e-6)), directionSign);
+
+	int level = 0;
+	// start one texel along the ray so it does not test the texel under the water fragment
+	vec2 startTexel = abs(inverseDirection) / vec2(textureSize(depthPyramid, 0));
+	float t = min(startTexel.x, startTexel.y);
+	for (int i = 0; i < maxTraceIterations && t <= 1.0; ++i) {
+		vec3 position = rayStart + rayDirection * t;
+		if (any(lessThan(position.xy, vec2(0.0))) || any(greaterThan(position.xy, vec2(1.0)))) {
+			break;
+		}
+		vec2 cellCount = vec2(textureSize(depthPyramid, level));
+		vec2 cell = floor(position.xy * cellCount);
+		vec2 boundary = (cell + directionSign) / cellCount;
+		vec2 boundaryT = (boundary - rayStart.xy) * inverseDirection;
+		float exitT = min(boundaryT.x, boundaryT.y) + 1e-5;
+		float exitDepth = rayStart.z + rayDirection.z * exitT;
+		float cellMinDepth = texelFetch(depthPyramid, ivec2(cell), level).r;
+
+		if (max(position.z, exitDepth) < cellMinDepth) {
+			// the whole segment through this cell is in front of everything in it, skip it at a coarser level
+			t = exitT;
+			level = min(level + 1, depthPyramidLevels - 1);
+		} else if (level > 0) {
+			--level;
+		} else if (linearDepth(position.z) - linearDepth(cellMinDepth) < hitThickness) {
+			vec2 edge = min(position.xy, 1.0 - position.xy);
+			float edgeFade = smoothstep(0.0, 0.1, min(edge.x, edge.y));
+			float distanceFade = 1.0 - smoothstep(0.7, 1.0, t);
+			return vec3(position.xy, edgeFade * distanceFade);
+		} else {
+			// passed behind a thin surface, keep going past it
+			t = exitT;
+		}
+	}
+	return vec3(0.0);
+}
+
 void main()
 {    
 	//Fresnel
@@ -34,8 +117,33 @@ void main()
 	reflectTexCoords.x = clamp(reflectTexCoords.x, 0.001, 0.999);
 	reflectTexCoords.y = clamp(reflectTexCoords.y, -0.999, -0.001);
 
-	vec4 reflectColour = texture(reflectionTexture, reflectTexCoords);
-	vec4 refractColour = texture(refractionTexture, refractTexCoords);
+	vec4 reflectColour;
+	vec4 refractColour;
+	if (multiView) {
+		reflectColour = texture(multiViewTexture, vec3(reflectTexCoords, 0.0));
+		refractColour = texture(multiViewTexture, vec3(refractTexCoords, 1.0));
+	} else {
+		if (screenSpaceReflection) {
+			vec3 normal = normalize(vec3(totalDistortion.x * reflectionNormalStrength, 1.0, totalDistortion.y * reflectionNormalStrength));
+			vec3 reflected = reflect(-viewVector, normal);
+			vec3 viewOrigin = (view * vec4(worldPosition, 1.0)).xyz;
+			vec3 viewDirection = normalize(mat3(view) * reflected);
+			vec3 hit = traceScreenSpaceRay(viewOrigin, viewDirection);
+			vec4 fallbackColour = skyboxFallback ? texture(skybox, reflected) : vec4(0.0, 0.0, 0.0, 1.0);
+			reflectColour = mix(fallbackColour, texture(sceneColorTexture, hit.xy), hit.z);
+		} else {
+			reflectColour = texture(reflectionTexture, reflectTexCoords);
+		}
+		if (screenSpaceRefraction) {
+			// anything nearer than the water surface at the distorted position is above the water, don't pull it in
+			if (texture(sceneDepthTexture, refractTexCoords).r < gl_FragCoord.z) {
+				refractTexCoords = clamp(ndc, 0.001, 0.999);
+			}
+			refractColour = texture(sceneColorTexture, refractTexCoords);
+		} else {
+			refractColour = texture(refractionTexture, refractTexCoords);
+		}
+	}
 
 	FragColor = mix(reflectColour, refractColour, refractiveFactor);
 }
\ No newline at end of file
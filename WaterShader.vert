@@ -7,9 +7,14 @@ uniform mat4 model;
 uniform mat4 matrixViewProjection;
 uniform vec3 viewPosition; //for fresnell effect
 
+// Compact meshes store positions as 16 bit fractions of their bounds, float ones get an identity decode
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
 out vec2 TexCoords;
 out vec3 toCameraVector; //for fresnell effect
 out vec4 clipSpace;
+out vec3 worldPosition;
 
 
 
@@ -17,9 +22,11 @@ const float tilingTextures = 8000.0;
 
 void main()
 {
-	vec4 objectPositionInWorld = model * vec4(aPos, 1.0);
+	vec3 position = positionOffset + aPos * positionScale;
+	vec4 objectPositionInWorld = model * vec4(position, 1.0);
 	clipSpace = matrixViewProjection * objectPositionInWorld;
-	TexCoords = vec2(aPos.x, aPos.z) / tilingTextures;
+	TexCoords = vec2(position.x, position.z) / tilingTextures;
     gl_Position = clipSpace;
+	worldPosition = objectPositionInWorld.xyz;
 	toCameraVector = viewPosition - (objectPositionInWorld).xyz;
 }
\ No newline at end of file